@@ -0,0 +1,224 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "CanvasBlend.h"
+
+#if defined(URHO3D_SSE)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CANVAS_NEON
+#endif
+
+//=============================================================================
+// scalar reference, the vector paths below produce identical results
+//=============================================================================
+static inline unsigned Div255(unsigned x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline unsigned BlendPixel(unsigned d, unsigned s, unsigned opacity, LayerBlendMode mode)
+{
+    unsigned sa = Div255((s >> 24) * opacity);
+    unsigned da = d >> 24;
+    unsigned result = 0;
+
+    for ( unsigned shift = 0; shift < 32; shift += 8 )
+    {
+        unsigned sc = Div255(((s >> shift) & 0xff) * opacity);
+        unsigned dc = (d >> shift) & 0xff;
+        unsigned c;
+
+        switch ( mode )
+        {
+        case LAYERBLEND_ADD:
+            c = sc + dc;
+            break;
+
+        case LAYERBLEND_MULTIPLY:
+            c = Div255(sc * dc) + Div255(sc * (255 - da)) + Div255(dc * (255 - sa));
+            break;
+
+        default:
+            c = sc + Div255(dc * (255 - sa));
+            break;
+        }
+
+        result |= (c > 255 ? 255 : c) << shift;
+    }
+
+    return result;
+}
+
+#if defined(URHO3D_SSE)
+//=============================================================================
+// SSE2 - 4 pixels per iteration, channels widened to 16 bits
+//=============================================================================
+static inline __m128i Div255Epi16(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static inline __m128i BroadcastAlpha(__m128i px)
+{
+    __m128i a = _mm_srli_epi32(px, 24);
+    a = _mm_or_si128(a, _mm_slli_epi32(a, 8));
+    return _mm_or_si128(a, _mm_slli_epi32(a, 16));
+}
+
+static inline __m128i Blend8(__m128i d, __m128i s, __m128i sa, __m128i da, LayerBlendMode mode)
+{
+    const __m128i c255 = _mm_set1_epi16(255);
+
+    switch ( mode )
+    {
+    case LAYERBLEND_ADD:
+        return _mm_add_epi16(s, d);
+
+    case LAYERBLEND_MULTIPLY:
+        return _mm_add_epi16(_mm_add_epi16(Div255Epi16(_mm_mullo_epi16(s, d)),
+                                           Div255Epi16(_mm_mullo_epi16(s, _mm_sub_epi16(c255, da)))),
+                             Div255Epi16(_mm_mullo_epi16(d, _mm_sub_epi16(c255, sa))));
+
+    default:
+        return _mm_add_epi16(s, Div255Epi16(_mm_mullo_epi16(d, _mm_sub_epi16(c255, sa))));
+    }
+}
+
+static void BlendSpanSSE2(unsigned *dest, const unsigned *src, unsigned count, unsigned opacity, LayerBlendMode mode)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i op = _mm_set1_epi16((short)opacity);
+
+    for ( unsigned i = 0; i < count; i += 4 )
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+
+        // apply layer opacity before taking the source alpha
+        __m128i sLo = Div255Epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), op));
+        __m128i sHi = Div255Epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), op));
+        s = _mm_packus_epi16(sLo, sHi);
+
+        __m128i sa = BroadcastAlpha(s);
+        __m128i da = BroadcastAlpha(d);
+
+        __m128i lo = Blend8(_mm_unpacklo_epi8(d, zero), sLo, _mm_unpacklo_epi8(sa, zero), _mm_unpacklo_epi8(da, zero), mode);
+        __m128i hi = Blend8(_mm_unpackhi_epi8(d, zero), sHi, _mm_unpackhi_epi8(sa, zero), _mm_unpackhi_epi8(da, zero), mode);
+
+        // packus saturates the add/multiply overflow to 255
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+}
+#elif defined(CANVAS_NEON)
+//=============================================================================
+// NEON - 4 pixels per iteration, channels widened to 16 bits
+//=============================================================================
+static inline uint16x8_t Div255U16(uint16x8_t x)
+{
+    x = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrq_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+
+static inline uint8x16_t BroadcastAlpha(uint8x16_t px)
+{
+    uint32x4_t a = vshrq_n_u32(vreinterpretq_u32_u8(px), 24);
+    a = vorrq_u32(a, vshlq_n_u32(a, 8));
+    return vreinterpretq_u8_u32(vorrq_u32(a, vshlq_n_u32(a, 16)));
+}
+
+static inline uint16x8_t Blend8(uint16x8_t d, uint16x8_t s, uint16x8_t sa, uint16x8_t da, LayerBlendMode mode)
+{
+    const uint16x8_t c255 = vdupq_n_u16(255);
+
+    switch ( mode )
+    {
+    case LAYERBLEND_ADD:
+        return vaddq_u16(s, d);
+
+    case LAYERBLEND_MULTIPLY:
+        return vaddq_u16(vaddq_u16(Div255U16(vmulq_u16(s, d)),
+                                   Div255U16(vmulq_u16(s, vsubq_u16(c255, da)))),
+                         Div255U16(vmulq_u16(d, vsubq_u16(c255, sa))));
+
+    default:
+        return vaddq_u16(s, Div255U16(vmulq_u16(d, vsubq_u16(c255, sa))));
+    }
+}
+
+static void BlendSpanNEON(unsigned *dest, const unsigned *src, unsigned count, unsigned opacity, LayerBlendMode mode)
+{
+    const uint16x8_t op = vdupq_n_u16((uint16_t)opacity);
+
+    for ( unsigned i = 0; i < count; i += 4 )
+    {
+        uint8x16_t s = vld1q_u8((const uint8_t*)(src + i));
+        uint8x16_t d = vld1q_u8((const uint8_t*)(dest + i));
+
+        // apply layer opacity before taking the source alpha
+        uint16x8_t sLo = Div255U16(vmulq_u16(vmovl_u8(vget_low_u8(s)), op));
+        uint16x8_t sHi = Div255U16(vmulq_u16(vmovl_u8(vget_high_u8(s)), op));
+        s = vcombine_u8(vqmovn_u16(sLo), vqmovn_u16(sHi));
+
+        uint8x16_t sa = BroadcastAlpha(s);
+        uint8x16_t da = BroadcastAlpha(d);
+
+        uint16x8_t lo = Blend8(vmovl_u8(vget_low_u8(d)), sLo, vmovl_u8(vget_low_u8(sa)), vmovl_u8(vget_low_u8(da)), mode);
+        uint16x8_t hi = Blend8(vmovl_u8(vget_high_u8(d)), sHi, vmovl_u8(vget_high_u8(sa)), vmovl_u8(vget_high_u8(da)), mode);
+
+        // saturating narrow clamps the add/multiply overflow to 255
+        vst1q_u8((uint8_t*)(dest + i), vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi)));
+    }
+}
+#endif
+
+void FillSpan(unsigned *dest, unsigned value, unsigned count)
+{
+    for ( unsigned i = 0; i < count; ++i )
+    {
+        dest[i] = value;
+    }
+}
+
+void BlendSpan(unsigned *dest, const unsigned *src, unsigned count, unsigned opacity, LayerBlendMode mode)
+{
+    if ( opacity == 0 )
+        return;
+
+    unsigned vecCount = count & ~3u;
+
+#if defined(URHO3D_SSE)
+    BlendSpanSSE2(dest, src, vecCount, opacity, mode);
+#elif defined(CANVAS_NEON)
+    BlendSpanNEON(dest, src, vecCount, opacity, mode);
+#else
+    vecCount = 0;
+#endif
+
+    for ( unsigned i = vecCount; i < count; ++i )
+    {
+        dest[i] = BlendPixel(dest[i], src[i], opacity, mode);
+    }
+}
+
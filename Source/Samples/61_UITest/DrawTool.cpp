@@ -28,17 +28,21 @@
 #include <Urho3D/UI/BorderImage.h>
 #include <Urho3D/UI/Font.h>
 #include <Urho3D/UI/Text.h>
+#include <Urho3D/UI/LineEdit.h>
+#include <Urho3D/UI/UI.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/Texture2D.h>
 #include <SDL/SDL_log.h>
 
 #include "DrawTool.h"
+#include "PageManager.h"
 
 #include <Urho3D/DebugNew.h>
 //=============================================================================
 //=============================================================================
 #define MIN_BAR_HEIGHT  30
+#define MIN_LEVEL_SIZE  32
 
 //=============================================================================
 //=============================================================================
@@ -51,7 +55,13 @@ DrawAreaBatcher::DrawAreaBatcher(Context *context)
     : BorderImage(context)
     , flushDrawBuffers_(false)
     , minLineLength_(8.0f)
+    , maxAngleDeviation_(4.0f)
     , pointListLimit_(100)
+    , predictStroke_(true)
+    , predictionShown_(false)
+    , predictFrames_(1.5f)
+    , maxPredictLength_(40.0f)
+    , shownBatchCount_(-1)
 {
 }
 
@@ -67,9 +77,29 @@ bool DrawAreaBatcher::Create(const IntVector2 &size, Texture2D *tex2d, const Int
     SetEnabled(true);
     SetSize(size);
 
+    PageManager *pageManager = GetSubsystem<PageManager>();
+    pageManager->AddPageActiveCallback(this, (PageActiveCallback)&DrawAreaBatcher::HandlePageActive);
+    SubscribeUpdate(pageManager->IsPageActive(this));
+
     return true;
 }
 
+void DrawAreaBatcher::SubscribeUpdate(bool subscribe)
+{
+    if ( subscribe )
+        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(DrawAreaBatcher, HandleUpdate));
+    else
+        UnsubscribeFromEvent(E_UPDATE);
+}
+
+void DrawAreaBatcher::HandlePageActive(bool active)
+{
+    SubscribeUpdate(active);
+
+    if ( !active )
+        pendingPointsList_.Clear();
+}
+
 bool DrawAreaBatcher::CreateLineBatcher(Texture2D *tex2d, const IntRect &rect)
 {
     if ( lineBatcher_ )
@@ -92,6 +122,9 @@ void DrawAreaBatcher::OnDragBegin(const IntVector2& position, const IntVector2&
                            int buttons, int qualifiers, Cursor* cursor)
 {
     drawPointsList_.Clear();
+    pendingPointsList_.Clear();
+    recentPointsList_.Clear();
+    predictionShown_ = false;
 }
 
 void DrawAreaBatcher::OnDragMove(const IntVector2& position, const IntVector2& screenPosition, 
@@ -100,26 +133,174 @@ void DrawAreaBatcher::OnDragMove(const IntVector2& position, const IntVector2& s
     if (buttons != MOUSEB_RIGHT || !InsideParent(position) || lineBatcher_ == NULL)
         return;
 
-    Vector2 vec((float)(lastPos_.x_ - screenPosition.x_), (float)(lastPos_.y_ - screenPosition.y_));
+    // high polling rate mice can send several moves per frame,
+    // collect them here and process once in HandleUpdate()
+    pendingPointsList_.Push( screenPosition );
+}
 
-    // limit the minimum line length to push onto the linebatcher
-    if ( vec.Length() < minLineLength_)
+void DrawAreaBatcher::OnDragEnd(const IntVector2& position, const IntVector2& screenPosition, 
+                                int dragButtons, int releaseButton, Cursor* cursor)
+{
+    for ( unsigned i = 0; i < pendingPointsList_.Size(); ++i )
+    {
+        FilterDrawPoint(pendingPointsList_[i]);
+    }
+
+    pendingPointsList_.Clear();
+    recentPointsList_.Clear();
+
+    // replace the provisional tail with the committed stroke
+    if ( lineBatcher_ && (predictionShown_ || drawPointsList_.Size() > 1) )
+    {
+        RedrawPoints(false);
+    }
+}
+
+void DrawAreaBatcher::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // the line is rebuilt when drawn, show the count from the last frame
+    if ( batchCountText_ && lineBatcher_ && lineBatcher_->GetBatchCount() != shownBatchCount_ )
+    {
+        shownBatchCount_ = lineBatcher_->GetBatchCount();
+        batchCountText_->SetText( String("batch count = ") + String(shownBatchCount_) );
+    }
+
+    if ( pendingPointsList_.Size() == 0 )
+    {
+        // cursor stopped, drop the provisional tail
+        if ( predictionShown_ )
+        {
+            recentPointsList_.Clear();
+            RedrawPoints(false);
+        }
         return;
+    }
+
+    bool changed = false;
 
-    lastPos_ = screenPosition;
+    for ( unsigned i = 0; i < pendingPointsList_.Size(); ++i )
+    {
+        if ( FilterDrawPoint(pendingPointsList_[i]) )
+            changed = true;
+    }
+
+    // keep the last sample of the most recent frames for velocity/curvature
+    recentPointsList_.Push( pendingPointsList_.Back() );
 
-    drawPointsList_.Push( screenPosition );
+    if ( recentPointsList_.Size() > 3 )
+        recentPointsList_.Erase(0);
 
-    if ( drawPointsList_.Size() > 1 )
+    pendingPointsList_.Clear();
+
+    if ( changed || predictStroke_ )
     {
-        lineBatcher_->DrawPoints(drawPointsList_);
+        RedrawPoints(predictStroke_);
+    }
+}
 
-        if (batchCountText_)
+void DrawAreaBatcher::RedrawPoints(bool predict)
+{
+    IntVector2 predicted;
+
+    displayPointsList_ = drawPointsList_;
+    predictionShown_ = false;
+
+    if ( predict && displayPointsList_.Size() > 0 && PredictTail(predicted) )
+    {
+        // the latest raw sample may have been filtered out of the committed list
+        if ( displayPointsList_.Back() != recentPointsList_.Back() )
+            displayPointsList_.Push( recentPointsList_.Back() );
+
+        displayPointsList_.Push( predicted );
+        predictionShown_ = true;
+    }
+
+    if ( displayPointsList_.Size() > 1 )
+    {
+        lineBatcher_->DrawPoints(displayPointsList_);
+    }
+    else
+    {
+        // too few committed points to draw, but a provisional tail may be on screen
+        lineBatcher_->ClearPointList();
+    }
+}
+
+bool DrawAreaBatcher::PredictTail(IntVector2 &predicted)
+{
+    unsigned numPts = recentPointsList_.Size();
+
+    if ( numPts < 2 )
+        return false;
+
+    // per frame velocity and change in velocity (curvature) of the last samples
+    const IntVector2 &p2 = recentPointsList_[numPts - 1];
+    const IntVector2 &p1 = recentPointsList_[numPts - 2];
+    Vector2 vel((float)(p2.x_ - p1.x_), (float)(p2.y_ - p1.y_));
+    Vector2 accel(Vector2::ZERO);
+
+    if ( numPts > 2 )
+    {
+        const IntVector2 &p0 = recentPointsList_[numPts - 3];
+        accel = vel - Vector2((float)(p1.x_ - p0.x_), (float)(p1.y_ - p0.y_));
+    }
+
+    float t = predictFrames_;
+    Vector2 offset = vel * t + accel * (0.5f * t * t);
+    float len = offset.Length();
+
+    if ( len < 1.0f )
+        return false;
+
+    if ( len > maxPredictLength_ )
+        offset *= maxPredictLength_ / len;
+
+    // keep the tail inside the draw area
+    IntVector2 minPos = GetScreenPosition();
+    IntVector2 maxPos = minPos + GetSize();
+
+    predicted.x_ = Clamp(p2.x_ + (int)offset.x_, minPos.x_, maxPos.x_);
+    predicted.y_ = Clamp(p2.y_ + (int)offset.y_, minPos.y_, maxPos.y_);
+
+    return (predicted != p2);
+}
+
+bool DrawAreaBatcher::FilterDrawPoint(const IntVector2 &pt)
+{
+    Vector2 vec((float)(pt.x_ - lastPos_.x_), (float)(pt.y_ - lastPos_.y_));
+
+    // limit the minimum line length to push onto the linebatcher
+    if ( drawPointsList_.Size() > 0 && vec.Length() < minLineLength_ )
+        return false;
+
+    lastPos_ = pt;
+    unsigned numPts = drawPointsList_.Size();
+
+    // extend the last segment while the run stays within the angular deviation
+    // of the direction it started with, so straight runs collapse to one segment
+    if ( numPts > 1 )
+    {
+        const IntVector2 &anchor = drawPointsList_[numPts - 2];
+        Vector2 chord((float)(pt.x_ - anchor.x_), (float)(pt.y_ - anchor.y_));
+
+        float cosAngle = Clamp(runDirection_.DotProduct(chord.Normalized()), -1.0f, 1.0f);
+
+        if ( chord.Length() > M_EPSILON && Acos(cosAngle) < maxAngleDeviation_ )
         {
-            String str = String("batch count = ") + String(lineBatcher_->GetBatchCount());
-            batchCountText_->SetText( str );
+            drawPointsList_[numPts - 1] = pt;
+            return true;
         }
     }
+
+    if ( numPts > 0 )
+    {
+        const IntVector2 &prev = drawPointsList_[numPts - 1];
+        runDirection_ = Vector2((float)(pt.x_ - prev.x_), (float)(pt.y_ - prev.y_)).Normalized();
+    }
+
+    drawPointsList_.Push( pt );
+
+    return true;
 }
 
 bool DrawAreaBatcher::InsideParent(const IntVector2 &p)
@@ -137,6 +318,16 @@ void DrawAreaTexure::RegisterObject(Context* context)
 
 DrawAreaTexure::DrawAreaTexure(Context *context)
     : BorderImage(context)
+    , viewLevel_(0)
+    , viewZoom_(1.0f)
+    , maxViewZoom_(32.0f)
+    , tool_(DRAWTOOL_PEN)
+    , drawColor_(Color::RED.ToUInt())
+    , dirty_(false)
+    , opDirty_(false)
+    , activeLayer_(0)
+    , backgroundColor_(Color::WHITE.ToUInt())
+    , maxUndoLevels_(20)
 {
 }
 
@@ -144,44 +335,215 @@ DrawAreaTexure::~DrawAreaTexure()
 {
 }
 
-bool DrawAreaTexure::Create(const IntVector2 &size)
+bool DrawAreaTexure::Create(const IntVector2 &size, const IntVector2 &textureSize)
 {
     // set texture format
     drawTexture_ = new Texture2D(context_);
-    textureSize_ = IntVector2( 256, 256 );
+    textureSize_ = textureSize;
 
-    textureScale_ = Vector2( (float)textureSize_.x_/ (float)size.x_, (float)textureSize_.y_/ (float)size.y_ );
     drawTexture_->SetMipsToSkip(QUALITY_LOW, 0);
     drawTexture_->SetNumLevels(1);
     drawTexture_->SetSize(textureSize_.x_, textureSize_.y_, Graphics::GetRGBAFormat(), TEXTURE_DYNAMIC);
 
     colorMap_ = new ColorMap(context_);
     colorMap_->SetSource(drawTexture_);
-    for (int y = 0; y < textureSize_.y_; ++y )
-    {
-        for (int x = 0; x < textureSize_.x_; ++x )
-        {
-            colorMap_->SetPixel(x, y, Color::WHITE);
-        }
-    }
-    colorMap_->ApplyColor();
 
-    SetTexture(drawTexture_);
+    CreateLevels();
+    viewCenter_ = Vector2((float)textureSize_.x_ * 0.5f, (float)textureSize_.y_ * 0.5f);
 
     SetEnabled(true);
     SetSize(size);
 
+    ClearBuffer();
+    ApplyDirty();
+
+    // keys only while our page is shown
+    PageManager *pageManager = GetSubsystem<PageManager>();
+    pageManager->AddPageActiveCallback(this, (PageActiveCallback)&DrawAreaTexure::HandlePageActive);
+    HandlePageActive(pageManager->IsPageActive(this));
+
     return true;
 }
 
+void DrawAreaTexure::HandlePageActive(bool active)
+{
+    if ( active )
+        SubscribeToEvent(E_KEYDOWN, URHO3D_HANDLER(DrawAreaTexure, HandleKeyDown));
+    else
+        UnsubscribeFromEvent(E_KEYDOWN);
+}
+
+void DrawAreaTexure::HandleKeyDown(StringHash eventType, VariantMap& eventData)
+{
+    using namespace KeyDown;
+
+    // text input has the keys
+    UIElement *focusElement = GetSubsystem<UI>()->GetFocusElement();
+
+    if ( focusElement && focusElement->IsInstanceOf<LineEdit>() )
+        return;
+
+    int key = eventData[P_KEY].GetInt();
+    int qualifiers = eventData[P_QUALIFIERS].GetInt();
+
+    if ( key == KEY_Z && (qualifiers & QUAL_CTRL) )
+    {
+        Undo();
+    }
+    else if ( key == KEY_F && qualifiers == 0 )
+    {
+        SetTool( tool_ == DRAWTOOL_PEN ? DRAWTOOL_FILL : DRAWTOOL_PEN );
+    }
+}
+
+void DrawAreaTexure::CreateLevels()
+{
+    IntVector2 levelSize = textureSize_;
+
+    levelList_.Clear();
+    levelList_.Resize(1);
+    levelList_[0].size_ = levelSize;
+    levelList_[0].texture_ = drawTexture_;
+
+    while ( levelSize.x_/2 >= MIN_LEVEL_SIZE && levelSize.y_/2 >= MIN_LEVEL_SIZE )
+    {
+        levelSize /= 2;
+
+        CanvasLevel level;
+        level.size_ = levelSize;
+        level.pixels_.Resize(levelSize.x_ * levelSize.y_);
+        levelList_.Push(level);
+    }
+}
+
 void DrawAreaTexure::ClearBuffer()
 {
+    unsigned numPixels = textureSize_.x_ * textureSize_.y_;
+
+    if ( layerList_.Size() == 0 )
+    {
+        layerList_.Resize(1);
+        activeLayer_ = 0;
+    }
+
+    for ( unsigned i = 0; i < layerList_.Size(); ++i )
+    {
+        CanvasLayer &layer = layerList_[i];
+        layer.pixels_.Resize(numPixels);
+        layer.undoBase_.Resize(numPixels);
+
+        if ( numPixels )
+        {
+            FillSpan(&layer.pixels_[0], 0, numPixels);
+            FillSpan(&layer.undoBase_[0], 0, numPixels);
+        }
+    }
+
+    undoList_.Clear();
+    opDirty_ = false;
+
+    MarkAllDirty();
+}
+
+unsigned DrawAreaTexure::AddLayer()
+{
+    unsigned numPixels = textureSize_.x_ * textureSize_.y_;
+
+    layerList_.Resize(layerList_.Size() + 1);
+
+    CanvasLayer &layer = layerList_.Back();
+    layer.pixels_.Resize(numPixels);
+    layer.undoBase_.Resize(numPixels);
+
+    if ( numPixels )
+    {
+        FillSpan(&layer.pixels_[0], 0, numPixels);
+        FillSpan(&layer.undoBase_[0], 0, numPixels);
+    }
+
+    return layerList_.Size() - 1;
+}
+
+void DrawAreaTexure::SetActiveLayer(unsigned idx)
+{
+    if ( idx >= layerList_.Size() || idx == activeLayer_ )
+        return;
+
+    // undo records belong to the layer they were taken from
+    CommitUndo();
+    activeLayer_ = idx;
+}
+
+void DrawAreaTexure::SetLayerOpacity(unsigned idx, float opacity)
+{
+    if ( idx < layerList_.Size() )
+    {
+        layerList_[idx].opacity_ = Clamp(opacity, 0.0f, 1.0f);
+        MarkAllDirty();
+        ApplyDirty();
+    }
+}
+
+void DrawAreaTexure::SetLayerBlendMode(unsigned idx, LayerBlendMode mode)
+{
+    if ( idx < layerList_.Size() )
+    {
+        layerList_[idx].blendMode_ = mode;
+        MarkAllDirty();
+        ApplyDirty();
+    }
+}
+
+void DrawAreaTexure::SetLayerVisible(unsigned idx, bool visible)
+{
+    if ( idx < layerList_.Size() )
+    {
+        layerList_[idx].visible_ = visible;
+        MarkAllDirty();
+        ApplyDirty();
+    }
+}
+
+void DrawAreaTexure::SetDrawColor(const Color &color)
+{
+    // layers are stored premultiplied
+    drawColor_ = Color(color.r_ * color.a_, color.g_ * color.a_, color.b_ * color.a_, color.a_).ToUInt();
+}
+
+IntVector2 DrawAreaTexure::ToTexturePos(const IntVector2 &position) const
+{
+    IntVector2 size = GetSize();
+
+    return IntVector2( viewRect_.left_ + position.x_ * viewRect_.Width() / Max(size.x_, 1),
+                       viewRect_.top_ + position.y_ * viewRect_.Height() / Max(size.y_, 1) );
+}
+
+void DrawAreaTexure::OnClickBegin(const IntVector2& position, const IntVector2& screenPosition, 
+                                  int button, int buttons, int qualifiers, Cursor* cursor)
+{
+    if (button != MOUSEB_RIGHT || tool_ != DRAWTOOL_FILL || !InsideParent(position) )
+        return;
+
+    IntVector2 p = ToTexturePos(position);
+
+    if ( FloodFill(p.x_, p.y_, drawColor_) )
+    {
+        CommitUndo();
+        ApplyDirty();
+    }
 }
 
 void DrawAreaTexure::OnDragBegin(const IntVector2& position, const IntVector2& screenPosition, 
                                  int buttons, int qualifiers, Cursor* cursor)
 {
-    if (buttons != MOUSEB_RIGHT || !InsideParent(position) )
+    if (buttons == MOUSEB_MIDDLE)
+    {
+        panBeginCursor_ = screenPosition;
+        panBeginCenter_ = viewCenter_;
+        return;
+    }
+
+    if (buttons != MOUSEB_RIGHT || tool_ != DRAWTOOL_PEN || !InsideParent(position) )
         return;
 
     lastPos_ = position;
@@ -190,18 +552,420 @@ void DrawAreaTexure::OnDragBegin(const IntVector2& position, const IntVector2& s
 void DrawAreaTexure::OnDragMove(const IntVector2& position, const IntVector2& screenPosition, 
                                 const IntVector2& deltaPos, int buttons, int qualifiers, Cursor* cursor)
 {
-    if (buttons != MOUSEB_RIGHT || !InsideParent(position) )
+    if (buttons == MOUSEB_MIDDLE)
+    {
+        IntVector2 size = GetSize();
+        IntVector2 delta = screenPosition - panBeginCursor_;
+        Vector2 scale((float)viewRect_.Width() / (float)Max(size.x_, 1), (float)viewRect_.Height() / (float)Max(size.y_, 1));
+
+        SetViewCenter(panBeginCenter_ - Vector2((float)delta.x_ * scale.x_, (float)delta.y_ * scale.y_));
+        return;
+    }
+
+    if (buttons != MOUSEB_RIGHT || tool_ != DRAWTOOL_PEN || !InsideParent(position) )
         return;
 
-    IntVector2 p0( (int)(textureScale_.x_ * (float)lastPos_.x_), (int)(textureScale_.y_ * (float)lastPos_.y_) );
-    IntVector2 p1( (int)(textureScale_.x_ * (float)position.x_), (int)(textureScale_.y_ * (float)position.y_) );
+    IntVector2 p0 = ToTexturePos(lastPos_);
+    IntVector2 p1 = ToTexturePos(position);
 
     lastPos_ = position;
 
     Bresenham(p0.x_, p0.y_, p1.x_, p1.y_);
 
     // update texture
-    colorMap_->ApplyColor();
+    ApplyDirty();
+}
+
+void DrawAreaTexure::OnDragEnd(const IntVector2& position, const IntVector2& screenPosition, 
+                               int dragButtons, int releaseButton, Cursor* cursor)
+{
+    // one undo record per stroke
+    CommitUndo();
+}
+
+void DrawAreaTexure::OnWheel(int delta, int buttons, int qualifiers)
+{
+    SetViewZoom(viewZoom_ * (delta > 0 ? 1.25f : 0.8f));
+}
+
+void DrawAreaTexure::SetViewZoom(float zoom)
+{
+    viewZoom_ = Clamp(zoom, 1.0f, maxViewZoom_);
+    UpdateView();
+}
+
+void DrawAreaTexure::SetViewCenter(const Vector2 &center)
+{
+    viewCenter_ = center;
+    UpdateView();
+}
+
+void DrawAreaTexure::PlotPixel(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= textureSize_.x_ || y >= textureSize_.y_)
+        return;
+
+    GetCanvasData()[y * textureSize_.x_ + x] = drawColor_;
+    MarkOpDirty(IntRect(x, y, x + 1, y + 1));
+}
+
+static void MergeRect(IntRect &dest, bool &valid, const IntRect &rect)
+{
+    if ( !valid )
+    {
+        dest = rect;
+        valid = true;
+    }
+    else
+    {
+        dest.left_   = Min(dest.left_, rect.left_);
+        dest.top_    = Min(dest.top_, rect.top_);
+        dest.right_  = Max(dest.right_, rect.right_);
+        dest.bottom_ = Max(dest.bottom_, rect.bottom_);
+    }
+}
+
+void DrawAreaTexure::MarkDirty(const IntRect &rect)
+{
+    MergeRect(dirtyRect_, dirty_, rect);
+}
+
+void DrawAreaTexure::MarkOpDirty(const IntRect &rect)
+{
+    MergeRect(opRect_, opDirty_, rect);
+    MergeRect(dirtyRect_, dirty_, rect);
+}
+
+void DrawAreaTexure::MarkAllDirty()
+{
+    MarkDirty(IntRect(0, 0, textureSize_.x_, textureSize_.y_));
+}
+
+void DrawAreaTexure::Composite(const IntRect &rect)
+{
+    unsigned *display = (unsigned*)colorMap_->GetData();
+    unsigned width = rect.right_ - rect.left_;
+
+    for ( int y = rect.top_; y < rect.bottom_; ++y )
+    {
+        unsigned offset = y * textureSize_.x_ + rect.left_;
+
+        FillSpan(display + offset, backgroundColor_, width);
+
+        for ( unsigned i = 0; i < layerList_.Size(); ++i )
+        {
+            const CanvasLayer &layer = layerList_[i];
+
+            if ( layer.visible_ )
+            {
+                BlendSpan(display + offset, &layer.pixels_[offset], width, (unsigned)(layer.opacity_ * 255.0f + 0.5f), layer.blendMode_);
+            }
+        }
+    }
+}
+
+void DrawAreaTexure::ApplyDirty()
+{
+    if ( !dirty_ )
+        return;
+
+    Composite(dirtyRect_);
+
+    MergeRect(levelList_[0].uploadRect_, levelList_[0].uploadDirty_, dirtyRect_);
+
+    if ( levelList_.Size() > 1 )
+    {
+        CanvasLevel &next = levelList_[1];
+        IntRect half(dirtyRect_.left_ >> 1, dirtyRect_.top_ >> 1,
+                     Min((dirtyRect_.right_ + 1) >> 1, next.size_.x_), Min((dirtyRect_.bottom_ + 1) >> 1, next.size_.y_));
+        MergeRect(next.buildRect_, next.buildDirty_, half);
+    }
+
+    dirty_ = false;
+
+    UpdateView();
+}
+
+static inline unsigned Average4(unsigned a, unsigned b, unsigned c, unsigned d)
+{
+    unsigned result = 0;
+
+    for ( unsigned shift = 0; shift < 32; shift += 8 )
+    {
+        unsigned sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+
+    return result;
+}
+
+void DrawAreaTexure::RebuildLevel(unsigned level)
+{
+    CanvasLevel &dest = levelList_[level];
+
+    if ( !dest.buildDirty_ )
+        return;
+
+    const CanvasLevel &srcLevel = levelList_[level - 1];
+    const unsigned *src = (level == 1) ? (const unsigned*)colorMap_->GetData() : &srcLevel.pixels_[0];
+    const IntVector2 &srcSize = srcLevel.size_;
+    const IntRect &rect = dest.buildRect_;
+
+    // 2x2 box filter, odd source edges are clamped
+    for ( int y = rect.top_; y < rect.bottom_; ++y )
+    {
+        const unsigned *row0 = src + (y * 2) * srcSize.x_;
+        const unsigned *row1 = src + Min(y * 2 + 1, srcSize.y_ - 1) * srcSize.x_;
+        unsigned *out = &dest.pixels_[y * dest.size_.x_];
+
+        for ( int x = rect.left_; x < rect.right_; ++x )
+        {
+            int x0 = x * 2;
+            int x1 = Min(x0 + 1, srcSize.x_ - 1);
+            out[x] = Average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+        }
+    }
+
+    MergeRect(dest.uploadRect_, dest.uploadDirty_, rect);
+
+    // the next level down is rebuilt on demand
+    if ( level + 1 < levelList_.Size() )
+    {
+        CanvasLevel &next = levelList_[level + 1];
+        IntRect half(rect.left_ >> 1, rect.top_ >> 1,
+                     Min((rect.right_ + 1) >> 1, next.size_.x_), Min((rect.bottom_ + 1) >> 1, next.size_.y_));
+        MergeRect(next.buildRect_, next.buildDirty_, half);
+    }
+
+    dest.buildDirty_ = false;
+}
+
+void DrawAreaTexure::UploadLevel(unsigned level)
+{
+    CanvasLevel &dest = levelList_[level];
+
+    if ( dest.texture_ == NULL )
+    {
+        dest.texture_ = new Texture2D(context_);
+        dest.texture_->SetMipsToSkip(QUALITY_LOW, 0);
+        dest.texture_->SetNumLevels(1);
+        dest.texture_->SetSize(dest.size_.x_, dest.size_.y_, Graphics::GetRGBAFormat(), TEXTURE_DYNAMIC);
+
+        dest.uploadRect_ = IntRect(0, 0, dest.size_.x_, dest.size_.y_);
+        dest.uploadDirty_ = true;
+    }
+
+    if ( !dest.uploadDirty_ )
+        return;
+
+    const IntRect &rect = dest.uploadRect_;
+
+    if ( level == 0 )
+    {
+        colorMap_->ApplyColor(rect);
+    }
+    else
+    {
+        dest.texture_->SetData(0, 0, rect.top_, dest.size_.x_, rect.bottom_ - rect.top_, &dest.pixels_[rect.top_ * dest.size_.x_]);
+    }
+
+    dest.uploadDirty_ = false;
+}
+
+void DrawAreaTexure::UpdateView()
+{
+    IntVector2 size = GetSize();
+
+    if ( levelList_.Size() == 0 || size.x_ <= 0 || size.y_ <= 0 )
+        return;
+
+    // visible canvas area, kept inside the canvas
+    Vector2 viewSize((float)textureSize_.x_ / viewZoom_, (float)textureSize_.y_ / viewZoom_);
+    Vector2 halfSize = viewSize * 0.5f;
+
+    viewCenter_.x_ = Clamp(viewCenter_.x_, halfSize.x_, (float)textureSize_.x_ - halfSize.x_);
+    viewCenter_.y_ = Clamp(viewCenter_.y_, halfSize.y_, (float)textureSize_.y_ - halfSize.y_);
+
+    viewRect_.left_   = (int)(viewCenter_.x_ - halfSize.x_);
+    viewRect_.top_    = (int)(viewCenter_.y_ - halfSize.y_);
+    viewRect_.right_  = viewRect_.left_ + Max((int)viewSize.x_, 1);
+    viewRect_.bottom_ = viewRect_.top_ + Max((int)viewSize.y_, 1);
+
+    // canvas pixels per screen pixel picks the pyramid level
+    float ratio = Min(viewSize.x_ / (float)size.x_, viewSize.y_ / (float)size.y_);
+    unsigned level = 0;
+
+    while ( level + 1 < levelList_.Size() && ratio >= 2.0f )
+    {
+        ratio *= 0.5f;
+        ++level;
+    }
+
+    for ( unsigned i = 1; i <= level; ++i )
+    {
+        RebuildLevel(i);
+    }
+
+    UploadLevel(level);
+
+    if ( level != viewLevel_ || GetTexture() != levelList_[level].texture_.Get() )
+    {
+        viewLevel_ = level;
+        SetTexture(levelList_[level].texture_);
+    }
+
+    SetImageRect(IntRect(viewRect_.left_ >> level, viewRect_.top_ >> level,
+                         Max(viewRect_.right_ >> level, (viewRect_.left_ >> level) + 1),
+                         Max(viewRect_.bottom_ >> level, (viewRect_.top_ >> level) + 1)));
+
+    // texture uploads need no new batches, a changed view does
+    GetSubsystem<PageManager>()->MarkPageDirty(this);
+}
+
+// scanline fill: fill the whole horizontal span around each seed, then push
+// one seed per run of target colored pixels in the rows above and below
+bool DrawAreaTexure::FloodFill(int x, int y, unsigned fillColor)
+{
+    const int width  = textureSize_.x_;
+    const int height = textureSize_.y_;
+
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return false;
+
+    unsigned *pixels = GetCanvasData();
+    unsigned target = pixels[y * width + x];
+
+    if ( target == fillColor )
+        return false;
+
+    IntRect bounds(x, y, x + 1, y + 1);
+
+    fillStack_.Clear();
+    fillStack_.Push(IntVector2(x, y));
+
+    while ( fillStack_.Size() > 0 )
+    {
+        IntVector2 seed = fillStack_.Back();
+        fillStack_.Pop();
+
+        unsigned *row = pixels + seed.y_ * width;
+
+        // already filled by an earlier span
+        if ( row[seed.x_] != target )
+            continue;
+
+        int left = seed.x_;
+        int right = seed.x_;
+
+        while ( left > 0 && row[left - 1] == target ) --left;
+        while ( right < width - 1 && row[right + 1] == target ) ++right;
+
+        for ( int i = left; i <= right; ++i )
+        {
+            row[i] = fillColor;
+        }
+
+        if ( left < bounds.left_ ) bounds.left_ = left;
+        if ( right + 1 > bounds.right_ ) bounds.right_ = right + 1;
+        if ( seed.y_ < bounds.top_ ) bounds.top_ = seed.y_;
+        if ( seed.y_ + 1 > bounds.bottom_ ) bounds.bottom_ = seed.y_ + 1;
+
+        if ( seed.y_ > 0 )
+            PushSpanSeeds(row - width, left, right, seed.y_ - 1, target);
+        if ( seed.y_ < height - 1 )
+            PushSpanSeeds(row + width, left, right, seed.y_ + 1, target);
+    }
+
+    MarkOpDirty(bounds);
+
+    return true;
+}
+
+void DrawAreaTexure::PushSpanSeeds(const unsigned *row, int left, int right, int y, unsigned target)
+{
+    bool inSpan = false;
+
+    for ( int i = left; i <= right; ++i )
+    {
+        if ( row[i] == target )
+        {
+            if ( !inSpan )
+            {
+                fillStack_.Push(IntVector2(i, y));
+                inSpan = true;
+            }
+        }
+        else
+        {
+            inSpan = false;
+        }
+    }
+}
+
+void DrawAreaTexure::CopyRect(unsigned *dest, const unsigned *src, const IntRect &rect, bool toRecord)
+{
+    int rectWidth = rect.right_ - rect.left_;
+
+    for ( int y = rect.top_; y < rect.bottom_; ++y )
+    {
+        unsigned canvasOffset = y * textureSize_.x_ + rect.left_;
+        unsigned recordOffset = (y - rect.top_) * rectWidth;
+
+        if ( toRecord )
+            memcpy(dest + recordOffset, src + canvasOffset, rectWidth * sizeof(unsigned));
+        else
+            memcpy(dest + canvasOffset, src + recordOffset, rectWidth * sizeof(unsigned));
+    }
+}
+
+void DrawAreaTexure::CommitUndo()
+{
+    if ( !opDirty_ )
+        return;
+
+    CanvasLayer &layer = layerList_[activeLayer_];
+
+    // save the previous pixels of the touched area, then bring the base up to date
+    CanvasUndo undo;
+    undo.layer_ = activeLayer_;
+    undo.rect_ = opRect_;
+    undo.pixels_.Resize(opRect_.Width() * opRect_.Height());
+    CopyRect(&undo.pixels_[0], &layer.undoBase_[0], opRect_, true);
+
+    for ( int y = opRect_.top_; y < opRect_.bottom_; ++y )
+    {
+        unsigned offset = y * textureSize_.x_ + opRect_.left_;
+        memcpy(&layer.undoBase_[offset], &layer.pixels_[offset], opRect_.Width() * sizeof(unsigned));
+    }
+
+    undoList_.Push(undo);
+
+    if ( undoList_.Size() > maxUndoLevels_ )
+        undoList_.Erase(0);
+
+    opDirty_ = false;
+}
+
+bool DrawAreaTexure::Undo()
+{
+    // finish any stroke in progress first
+    CommitUndo();
+
+    if ( undoList_.Size() == 0 )
+        return false;
+
+    CanvasUndo &undo = undoList_.Back();
+    CanvasLayer &layer = layerList_[undo.layer_];
+
+    CopyRect(&layer.pixels_[0], &undo.pixels_[0], undo.rect_, false);
+    CopyRect(&layer.undoBase_[0], &undo.pixels_[0], undo.rect_, false);
+
+    MarkDirty(undo.rect_);
+    ApplyDirty();
+
+    undoList_.Pop();
+
+    return true;
 }
 
 // from:
@@ -219,7 +983,7 @@ void DrawAreaTexure::Bresenham(int x1, int y1, int const x2, int const y2)
     delta_y = std::abs(delta_y) << 1;
  
     //plot(x1, y1);
-    colorMap_->SetPixel(x1, y1, Color::RED);
+    PlotPixel(x1, y1);
  
     if (delta_x >= delta_y)
     {
@@ -239,7 +1003,7 @@ void DrawAreaTexure::Bresenham(int x1, int y1, int const x2, int const y2)
             x1 += ix;
  
             //plot(x1, y1);
-            colorMap_->SetPixel(x1, y1, Color::RED);
+            PlotPixel(x1, y1);
         }
     }
     else
@@ -260,7 +1024,7 @@ void DrawAreaTexure::Bresenham(int x1, int y1, int const x2, int const y2)
             y1 += iy;
  
             //plot(x1, y1);
-            colorMap_->SetPixel(x1, y1, Color::RED);
+            PlotPixel(x1, y1);
         }
     }
 }
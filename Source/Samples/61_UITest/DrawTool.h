@@ -22,6 +22,7 @@
 #pragma once
 #include <Urho3D/UI/BorderImage.h>
 #include "LineBatcher.h"
+#include "CanvasBlend.h"
 
 namespace Urho3D
 {
@@ -53,23 +54,48 @@ public:
     virtual void OnDragMove(const IntVector2& position, const IntVector2& screenPosition, 
                             const IntVector2& deltaPos, int buttons, int qualifiers, Cursor* cursor);
 
+    virtual void OnDragEnd(const IntVector2& position, const IntVector2& screenPosition, 
+                           int dragButtons, int releaseButton, Cursor* cursor);
+
     void SetBatchCountText(Text *text) { batchCountText_ = text;}
+    void SetMinLineLength(float len) { minLineLength_ = len; }
+    void SetMaxAngleDeviation(float degrees) { maxAngleDeviation_ = degrees; }
+    void SetPredictStroke(bool predict) { predictStroke_ = predict; }
+    void SetPredictFrames(float frames) { predictFrames_ = frames; }
 
 protected:
     bool CreateLineBatcher(Texture2D *tex2d, const IntRect &rect);
     bool InsideParent(const IntVector2 &position);
+    bool FilterDrawPoint(const IntVector2 &pt);
+    bool PredictTail(IntVector2 &predicted);
+    void RedrawPoints(bool predict);
+    void SubscribeUpdate(bool subscribe);
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePageActive(bool active);
 
 protected:
     WeakPtr<LineBatcher>  lineBatcher_;
 
     PODVector<IntVector2> drawPointsList_;
+    PODVector<IntVector2> pendingPointsList_;
+    PODVector<IntVector2> recentPointsList_;
+    PODVector<IntVector2> displayPointsList_;
     int                   drawPointsIndex_;
     bool                  flushDrawBuffers_;
     float                 minLineLength_;
+    float                 maxAngleDeviation_;
+    Vector2               runDirection_;
     IntVector2            lastPos_;
     unsigned              pointListLimit_;
 
+    // provisional tail drawn ahead of the committed stroke
+    bool                  predictStroke_;
+    bool                  predictionShown_;
+    float                 predictFrames_;
+    float                 maxPredictLength_;
+
     WeakPtr<Text>            batchCountText_;
+    int                      shownBatchCount_;
 
 };
 
@@ -93,10 +119,55 @@ public:
         textureSrc_->SetData( 0, 0, 0, GetWidth(), GetHeight(), GetData() );
     }
 
+    // uploads the full width rows covering the rect, the rows are contiguous
+    // in the image data so no staging copy is needed
+    void ApplyColor(const IntRect &rect)
+    {
+        int rowBytes = GetWidth() * GetComponents();
+        textureSrc_->SetData( 0, 0, rect.top_, GetWidth(), rect.bottom_ - rect.top_, GetData() + rect.top_ * rowBytes );
+    }
+
 protected:
     WeakPtr<Texture2D> textureSrc_;
 };
 
+enum DrawTextureTool
+{
+    DRAWTOOL_PEN,
+    DRAWTOOL_FILL,
+};
+
+struct CanvasUndo
+{
+    unsigned            layer_;
+    IntRect             rect_;
+    PODVector<unsigned> pixels_;
+};
+
+struct CanvasLayer
+{
+    CanvasLayer() : opacity_(1.0f), blendMode_(LAYERBLEND_NORMAL), visible_(true) {}
+
+    PODVector<unsigned> pixels_;    // premultiplied alpha
+    PODVector<unsigned> undoBase_;  // state as of the last committed operation
+    float               opacity_;
+    LayerBlendMode      blendMode_;
+    bool                visible_;
+};
+
+struct CanvasLevel
+{
+    CanvasLevel() : buildDirty_(false), uploadDirty_(false) {}
+
+    IntVector2           size_;
+    PODVector<unsigned>  pixels_;       // unused for level 0, see ColorMap
+    SharedPtr<Texture2D> texture_;
+    IntRect              buildRect_;    // needs downsampling from the level above
+    IntRect              uploadRect_;   // needs uploading to the texture
+    bool                 buildDirty_;
+    bool                 uploadDirty_;
+};
+
 class DrawAreaTexure : public BorderImage
 {
     URHO3D_OBJECT(DrawAreaTexure, BorderImage);
@@ -106,26 +177,103 @@ public:
     DrawAreaTexure(Context *context);
     virtual ~DrawAreaTexure();
 
-    bool Create(const IntVector2 &size);
+    bool Create(const IntVector2 &size, const IntVector2 &textureSize = IntVector2(256, 256));
+    virtual void OnClickBegin(const IntVector2& position, const IntVector2& screenPosition, 
+                              int button, int buttons, int qualifiers, Cursor* cursor);
+
     virtual void OnDragBegin(const IntVector2& position, const IntVector2& screenPosition, 
                              int buttons, int qualifiers, Cursor* cursor);
 
     virtual void OnDragMove(const IntVector2& position, const IntVector2& screenPosition, 
                             const IntVector2& deltaPos, int buttons, int qualifiers, Cursor* cursor);
 
+    virtual void OnDragEnd(const IntVector2& position, const IntVector2& screenPosition, 
+                           int dragButtons, int releaseButton, Cursor* cursor);
+
+    virtual void OnWheel(int delta, int buttons, int qualifiers);
+
+    void SetTool(DrawTextureTool tool)     { tool_ = tool; }
+    DrawTextureTool GetTool() const        { return tool_; }
+    void SetDrawColor(const Color &color);
+    void SetMaxUndoLevels(unsigned levels) { maxUndoLevels_ = levels; }
+
+    // layers, composited over the background color into the displayed texture
+    unsigned AddLayer();
+    unsigned GetNumLayers() const              { return layerList_.Size(); }
+    void SetActiveLayer(unsigned idx);
+    unsigned GetActiveLayer() const            { return activeLayer_; }
+    void SetLayerOpacity(unsigned idx, float opacity);
+    void SetLayerBlendMode(unsigned idx, LayerBlendMode mode);
+    void SetLayerVisible(unsigned idx, bool visible);
+
+    // view transform, zoom 1 shows the whole canvas, MMB drag pans and the wheel zooms
+    void SetViewZoom(float zoom);
+    float GetViewZoom() const                  { return viewZoom_; }
+    void SetViewCenter(const Vector2 &center);
+    const Vector2& GetViewCenter() const       { return viewCenter_; }
+
+    bool FloodFill(int x, int y, unsigned fillColor);
+    bool Undo();
+
 protected:
+    void HandlePageActive(bool active);
+    void HandleKeyDown(StringHash eventType, VariantMap& eventData);
     void ClearBuffer();
     void Bresenham(int x1, int y1, int x2, int y2);
     bool InsideParent(const IntVector2 &position);
+    IntVector2 ToTexturePos(const IntVector2 &position) const;
+
+    unsigned* GetCanvasData() { return &layerList_[activeLayer_].pixels_[0]; }
+    void PlotPixel(int x, int y);
+    void PushSpanSeeds(const unsigned *row, int left, int right, int y, unsigned target);
+    void MarkDirty(const IntRect &rect);
+    void MarkOpDirty(const IntRect &rect);
+    void MarkAllDirty();
+    void Composite(const IntRect &rect);
+    void ApplyDirty();
+
+    void CreateLevels();
+    void RebuildLevel(unsigned level);
+    void UploadLevel(unsigned level);
+    void UpdateView();
+    void CommitUndo();
+    void CopyRect(unsigned *dest, const unsigned *src, const IntRect &rect, bool toRecord);
 
 protected:
     SharedPtr<Texture2D> drawTexture_;
     SharedPtr<ColorMap>  colorMap_;
 
     IntVector2           textureSize_;
-    Vector2              textureScale_;
     IntVector2           lastPos_;
     unsigned             pointListLimit_;
+
+    // downsampled pyramid, the view samples the smallest level that still
+    // has at least one texel per screen pixel
+    Vector<CanvasLevel>  levelList_;
+    unsigned             viewLevel_;
+    float                viewZoom_;
+    float                maxViewZoom_;
+    Vector2              viewCenter_;
+    IntRect              viewRect_;
+    IntVector2           panBeginCursor_;
+    Vector2              panBeginCenter_;
+
+    DrawTextureTool      tool_;
+    unsigned             drawColor_;
+    PODVector<IntVector2> fillStack_;
+
+    // dirty rect waiting for upload and the area touched by the current operation
+    IntRect              dirtyRect_;
+    IntRect              opRect_;
+    bool                 dirty_;
+    bool                 opDirty_;
+
+    Vector<CanvasLayer>  layerList_;
+    unsigned             activeLayer_;
+    unsigned             backgroundColor_;
+
+    Vector<CanvasUndo>   undoList_;
+    unsigned             maxUndoLevels_;
 };
 
 //=============================================================================
@@ -146,6 +294,9 @@ public:
     void SetHeaderText(const String& text);
     void SetScreenColor(const Color &color);
 
+    DrawAreaBatcher* GetDrawAreaBatcher() { return drawArea_;        }
+    DrawAreaTexure* GetDrawAreaTexture()  { return drawAreaTexture_; }
+
 protected:
     bool InitInternal(const IntVector2 &size);
     bool CreateDrawArea(const IntVector2 &size, Texture2D *tex2d, const IntRect &rect);
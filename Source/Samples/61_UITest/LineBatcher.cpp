@@ -33,6 +33,7 @@
 #include <SDL/SDL_log.h>
 
 #include "LineBatcher.h"
+#include "PageManager.h"
 
 #include <Urho3D/DebugNew.h>
 
@@ -69,6 +70,7 @@ LineBatcher::LineBatcher(Context *context)
     , numPtsPerSegment_(0)
     , invLineTextureWidth_(1)
     , invLineTextureHeight_(1)
+    , batchesDirty_(false)
 {
     SetSize(1, 1);
 }
@@ -81,8 +83,8 @@ void LineBatcher::SetBlendMode(BlendMode mode)
 {
     blendMode_ = mode;
 
-    // redraw if we have a batch
-    if (batches_.Size() > 0 && pointList_.Size() > 0)
+    // redraw if we have a line
+    if (pointList_.Size() > 1)
     {
         DrawInternalPoints();
     }
@@ -92,8 +94,8 @@ void LineBatcher::SetColor(const Color& color)
 {
     UIElement::SetColor(color);
 
-    // redraw if we have a batch
-    if (batches_.Size() > 0 && pointList_.Size() > 0)
+    // redraw if we have a line
+    if (pointList_.Size() > 1)
     {
         DrawInternalPoints();
     }
@@ -103,8 +105,8 @@ void LineBatcher::SetColor(Corner corner, const Color& color)
 {
     UIElement::SetColor(corner, color);
 
-    // redraw if we have a batch
-    if (batches_.Size() > 0 && pointList_.Size() > 0)
+    // redraw if we have a line
+    if (pointList_.Size() > 1)
     {
         DrawInternalPoints();
     }
@@ -148,34 +150,47 @@ void LineBatcher::DrawPoints(const PODVector<IntVector2> &points)
     assert(points.Size() > 1 && "try adding more draw points");
 
     // clear
-    ClearPointList();
-    ClearBatchList();
+    pointList_.Clear();
 
     // add
     AddPoints(points);
 
-    // process
-    if ( lineType_ == STRAIGHT_LINE )
-        CreateLineSegments();
-    else
-        CreateCurveSegments();
+    // process on the next GetBatches()
+    DrawInternalPoints();
 }
 
 void LineBatcher::DrawInternalPoints()
 {
+    batchesDirty_ = true;
+    GetSubsystem<PageManager>()->MarkPageDirty(this);
+}
+
+void LineBatcher::UpdateBatches()
+{
+    if ( !batchesDirty_ )
+        return;
+
     // clear
     ClearBatchList();
 
     // process
-    if ( lineType_ == STRAIGHT_LINE )
-        CreateLineSegments();
-    else
-        CreateCurveSegments();
+    if ( pointList_.Size() > 1 )
+    {
+        if ( lineType_ == STRAIGHT_LINE )
+            CreateLineSegments();
+        else
+            CreateCurveSegments();
+    }
+
+    batchesDirty_ = false;
 }
 
 void LineBatcher::ClearPointList()
 {
     pointList_.Clear();
+
+    // drop the drawn line as well
+    DrawInternalPoints();
 }
 
 void LineBatcher::ClearBatchList()
@@ -297,6 +312,8 @@ bool LineBatcher::ValidateTextures() const
 
 void LineBatcher::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
 {
+    UpdateBatches();
+
     for ( unsigned i = 0; i < batches_.Size(); ++i )
     {
         UIBatch &batch     = batches_[ i ];
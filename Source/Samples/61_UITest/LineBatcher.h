@@ -83,6 +83,7 @@ public:
     void DrawPoints(const PODVector<IntVector2> &points);
     void ClearPointList();
     void ClearBatchList();
+    // batches built by the last GetBatches(), doesn't force a rebuild
     int GetBatchCount() const { return (int)batches_.Size(); }
 
     // virtual override
@@ -90,6 +91,7 @@ public:
 
 protected:
     void DrawInternalPoints();
+    void UpdateBatches();
 
     void CreateLineSegments();
     void CreateCurveSegments();
@@ -121,5 +123,8 @@ protected:
     PODVector<RectVectors>  rectVectorList_;
     PODVector<float>        vertexData_;
     PODVector<UIBatch>      batches_;
+
+    // geometry is rebuilt in GetBatches(), so lines on hidden pages cost nothing
+    bool                    batchesDirty_;
 };
 
@@ -33,6 +33,7 @@
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/Zone.h>
 #include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/Image.h>
 
 #include "Main.h"
 
@@ -40,6 +41,7 @@
 #include "RadialGroup.h"
 #include "TabGroup.h"
 #include "SpriteAnimBox.h"
+#include "SpriteAnimator.h"
 #include "LineBatcher.h"
 #include "LineComponent.h"
 #include "DrawTool.h"
@@ -51,6 +53,7 @@
 #include "TimeVarNode.h"
 #include "InputNode.h"
 #include "OutputNode.h"
+#include "GraphPlan.h"
 
 #include <Urho3D/DebugNew.h>
 //=============================================================================
@@ -67,6 +70,7 @@ Main::Main(Context* context) :
     RadialGroup::RegisterObject(context);
     TabGroup::RegisterObject(context);
     SpriteAnimBox::RegisterObject(context);
+    SpriteAnimator::RegisterObject(context);
     LineBatcher::RegisterObject(context);
     StaticLine::RegisterObject(context);
     ControlLine::RegisterObject(context);
@@ -116,10 +120,55 @@ void Main::Start()
 void Main::CreatePageManager()
 {
     PageManager *pageManager = GetSubsystem<PageManager>();
-    pageManager->CreatePages(2);
+    pageManager->CreatePages(3);
 }
 
 void Main::CreateGUI()
+{
+    PageManager *pageManager = GetSubsystem<PageManager>();
+
+    // pages are built on their first visit
+    pageManager->SetPageBuilder(0, this, (PageBuildCallback)&Main::BuildControlsPage);
+    pageManager->SetPageBuilder(1, this, (PageBuildCallback)&Main::BuildNodeGraphPage);
+    pageManager->SetPageBuilder(2, this, (PageBuildCallback)&Main::BuildCanvasPage);
+
+    // resources prefetched in the background while a neighbouring page is shown
+    pageManager->AddPageResource<XMLFile>(0, "UI/DefaultStyle.xml");
+    pageManager->AddPageResource<XMLFile>(0, "UI/EditorIcons.xml");
+    pageManager->AddPageResource<Font>(0, "Fonts/Anonymous Pro.ttf");
+    pageManager->AddPageResource<Texture2D>(0, "Textures/UI.png");
+
+    for (int i = 1; i <= 5; ++i)
+    {
+        pageManager->AddPageResource<Image>(0, "Urho2D/GoldIcon/" + String(i) + ".png");
+    }
+
+    pageManager->AddPageResource<Font>(1, "Fonts/Anonymous Pro.ttf");
+    pageManager->AddPageResource<Texture2D>(1, "Textures/UI.png");
+    pageManager->AddPageResource<Texture2D>(1, "Textures/SignalPanel.png");
+    pageManager->AddPageResource<Texture2D>(1, "Urho2D/Ball.png");
+
+    pageManager->AddPageResource<Font>(2, "Fonts/Anonymous Pro.ttf");
+    pageManager->AddPageResource<Texture2D>(2, "Textures/UI.png");
+
+    // the node graph page is restored from its snapshot after the first run,
+    // bump the version when CreateSliderBarInput() or CreateNodeGraph() change
+    String snapshotDir = GetSubsystem<FileSystem>()->GetAppPreferencesDir("urho3d", "61_UITest");
+    pageManager->SetPageSnapshotFile(1, snapshotDir + "NodeGraphPage.bin", 1, (PageBuildCallback)&Main::RestoreNodeGraphPage);
+
+    // the controls page is static between interactions except for the sprite
+    // anim box, which is live; the node graph animates every frame
+    pageManager->SetPageFrozen(0, true);
+
+    // room for the larger page and a bit, with both pages built the least
+    // recently visited one is unloaded and rebuilt on its next visit
+    pageManager->SetElementBudget(300);
+
+    // set page
+    pageManager->SetPageIndex(0);
+}
+
+void Main::BuildControlsPage()
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     PageManager* ui = GetSubsystem<PageManager>();
@@ -131,16 +180,27 @@ void Main::CreateGUI()
     CreateSpriteAnimBox();
     CreateLineComponents();
     CreateDrawTool();
+}
 
-    // set page
-    PageManager *pageManager = GetSubsystem<PageManager>();
-    pageManager->SetPageIndex(1);
-
+void Main::BuildNodeGraphPage()
+{
     CreateSliderBarInput();
     CreateNodeGraph();
+}
 
-    // set page
-    pageManager->SetPageIndex(0);
+void Main::BuildCanvasPage()
+{
+    CreateCanvasDrawTool();
+}
+
+void Main::RestoreNodeGraphPage()
+{
+    PageManager* ui = GetSubsystem<PageManager>();
+    UIElement* root = ui->GetRoot();
+
+    // the elements come from the snapshot, only the code side is attached here
+    AttachColorCallback((SlideVarNode*)root->GetChild("ScreenColorNode", true));
+    AttachInputProcessor((OutputNode*)root->GetChild("InputSumOut", true));
 }
 
 void Main::CreateRadialGroup()
@@ -208,20 +268,29 @@ void Main::CreateTabGroup()
         tabElement->tabText_->SetColor(Color(0.9f, 0.9f, 0.0f));
 
         tabElement->tabButton_->SetColor(Color(0.3f,0.7f,0.3f));
-        tabElement->tabBody_->SetColor(Color(0.3f,0.7f,0.3f));
-
-        Text *bodyText = tabElement->tabBody_->CreateChild<Text>();
-        bodyText->SetAlignment(HA_CENTER, VA_CENTER);
-        bodyText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 16);
-        String btext = "Tab body " + String(i+1);
-        bodyText->SetText(btext);
-        bodyText->SetColor(Color(0.9f, 0.9f, 0.0f));
     }
 
+    // bodies are filled in when their tab is first selected
+    tabgroup->SetTabBuilder(this, (TabBuildCallback)&Main::BuildTabBody);
     tabgroup->SetEnabled(true);
     SubscribeToEvent(E_TABSELECTED, URHO3D_HANDLER(Main, HandleTabSelected));
 }
 
+void Main::BuildTabBody(TabGroup *tabGroup, unsigned idx)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    BorderImage *tabBody = tabGroup->GetTabElement(idx)->tabBody_;
+
+    tabBody->SetColor(Color(0.3f,0.7f,0.3f));
+
+    Text *bodyText = tabBody->CreateChild<Text>();
+    bodyText->SetAlignment(HA_CENTER, VA_CENTER);
+    bodyText->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 16);
+    String btext = "Tab body " + String(idx+1);
+    bodyText->SetText(btext);
+    bodyText->SetColor(Color(0.9f, 0.9f, 0.0f));
+}
+
 void Main::CreateSpriteAnimBox()
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -246,6 +315,9 @@ void Main::CreateSpriteAnimBox()
 
     animbox->SetFPS(20.0f);
     animbox->SetEnabled(true);
+
+    // animates every frame, kept out of the frozen page capture
+    ui->SetElementLive(animbox, true);
 }
 
 void Main::CreateLineComponents()
@@ -296,19 +368,6 @@ void Main::CreateDrawTool()
     Texture2D *uiTex2d = cache->GetResource<Texture2D>("Textures/UI.png");
     IntRect rect(84,87,85,88);
 
-#ifdef SHOW_TEXT_DRAWTOOL
-    // texture draw tool
-    DrawTool *drawtoolTexture = root->CreateChild<DrawTool>();
-
-    if ( drawtoolTexture->Create( IntVector2(500, 330), uiTex2d, rect, false) )
-    {
-        drawtoolTexture->SetPosition(700, 350);
-        drawtoolTexture->SetColor(Color(0.2f,0.2f,0.2f));
-        drawtoolTexture->SetHeaderFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 10);
-        drawtoolTexture->SetHeaderText("Drawtool Texture (right mouse click to draw)");
-    }
-#endif
-
     // linebatcher draw tool
     DrawTool *drawtoolLineBatcher = root->CreateChild<DrawTool>();
 
@@ -323,6 +382,26 @@ void Main::CreateDrawTool()
     }
 }
 
+void Main::CreateCanvasDrawTool()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    PageManager* ui = GetSubsystem<PageManager>();
+    UIElement* root = ui->GetRoot();
+    Texture2D *uiTex2d = cache->GetResource<Texture2D>("Textures/UI.png");
+    IntRect rect(84,87,85,88);
+
+    // texture draw tool
+    DrawTool *drawtoolTexture = root->CreateChild<DrawTool>();
+
+    if ( drawtoolTexture->Create( IntVector2(500, 330), uiTex2d, rect, false) )
+    {
+        drawtoolTexture->SetPosition(120, 120);
+        drawtoolTexture->SetColor(Color(0.2f,0.2f,0.2f));
+        drawtoolTexture->SetHeaderFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 10);
+        drawtoolTexture->SetHeaderText("Drawtool Texture (RMB to draw, F: pen/fill, Ctrl+Z: undo)");
+    }
+}
+
 void Main::CreateSliderBarInput()
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -332,6 +411,7 @@ void Main::CreateSliderBarInput()
     // create and init nodebase
     IntVector2 pos00(20,100);
     SlideVarNode *slideVarNode = root->CreateChild<SlideVarNode>();
+    slideVarNode->SetName("ScreenColorNode");
     slideVarNode->SetPosition(pos00);
     slideVarNode->SetHeaderFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 10);
     slideVarNode->SetHeaderText("Screen color");
@@ -349,31 +429,7 @@ void Main::CreateSliderBarInput()
     slideVarNode->SetCurrentValue((Variant)colorBackground_.r_);
     slideVarNode->SetSensitivity(0.005f);
 
-    // ui callback helper - a direct and alternative method to get events
-    // you can use a typical event handler instead, e.g. HandleMessage(StringHash eventType, VariantMap& eventData);
-    // register for E_SLIDEBAR_VARCHANGED
-    class UICallbackHelper : public UIElement
-    {
-        URHO3D_OBJECT(UICallbackHelper, UIElement);
-    public:
-        UICallbackHelper(Context *context) : UIElement(context){}
-        virtual ~UICallbackHelper(){}
-        void SetBackgroundColor(const Color &color) { colorBackground_ = color; }
-        void RedColorHandler(Variant &var)
-        {
-            colorBackground_.r_ = var.GetFloat();
-            GetSubsystem<Renderer>()->GetDefaultZone()->SetFogColor(colorBackground_);
-        }
-
-    protected:
-        Color colorBackground_;
-    };
-
-    // setup the callback helper
-    UICallbackHelper *colorChangedHelper = new UICallbackHelper(context_);
-    root->AddChild(colorChangedHelper);
-    colorChangedHelper->SetBackgroundColor(colorBackground_);
-    slideVarNode->SetVarChangedCallback(colorChangedHelper, (VarChangedCallback)&UICallbackHelper::RedColorHandler);
+    AttachColorCallback(slideVarNode);
 }
 
 void Main::CreateNodeGraph()
@@ -411,6 +467,7 @@ void Main::CreateNodeGraph()
 
     OutputNode *outNode2 = nodeBase5->CreateChild<OutputNode>();
     outNode2->Create("out", size25);
+    outNode2->SetName("InputSumOut");
     outNode2->SetEnableCtrlButton(false); // lock
 
     //===========================================
@@ -495,6 +552,46 @@ void Main::CreateNodeGraph()
     timeVarNodeY->ConnectToInput(inputNodeY); // connect input
     timeVarNodeY->SetEnableCtrlButton(false); // lock
 
+    AttachInputProcessor(outNode2);
+}
+
+void Main::AttachColorCallback(SlideVarNode *slideVarNode)
+{
+    PageManager* ui = GetSubsystem<PageManager>();
+    UIElement* root = ui->GetRoot();
+
+    // ui callback helper - a direct and alternative method to get events
+    // you can use a typical event handler instead, e.g. HandleMessage(StringHash eventType, VariantMap& eventData);
+    // register for E_SLIDEBAR_VARCHANGED
+    class UICallbackHelper : public UIElement
+    {
+        URHO3D_OBJECT(UICallbackHelper, UIElement);
+    public:
+        UICallbackHelper(Context *context) : UIElement(context){}
+        virtual ~UICallbackHelper(){}
+        void SetBackgroundColor(const Color &color) { colorBackground_ = color; }
+        void RedColorHandler(Variant &var)
+        {
+            colorBackground_.r_ = var.GetFloat();
+            GetSubsystem<Renderer>()->GetDefaultZone()->SetFogColor(colorBackground_);
+        }
+
+    protected:
+        Color colorBackground_;
+    };
+
+    // setup the callback helper
+    UICallbackHelper *colorChangedHelper = new UICallbackHelper(context_);
+    root->AddChild(colorChangedHelper);
+    colorChangedHelper->SetBackgroundColor(colorBackground_);
+    slideVarNode->SetVarChangedCallback(colorChangedHelper, (VarChangedCallback)&UICallbackHelper::RedColorHandler);
+}
+
+void Main::AttachInputProcessor(OutputNode *outputNode)
+{
+    PageManager* ui = GetSubsystem<PageManager>();
+    UIElement* root = ui->GetRoot();
+
     //===========================================
     // InputProcessor
     //===========================================
@@ -504,16 +601,18 @@ void Main::CreateNodeGraph()
 
         struct BallData
         {
-            BallData() : sprite(NULL), pos(0,0), time(0.0f) {}
+            BallData() : sprite(NULL), pos(0,0), timeOffset(0.0f) {}
 
             Sprite  *sprite;
             Vector2 pos;
-            float   time;
+            float   timeOffset;
         };
     public:
         InputProcessor(Context *context) : UIElement(context) , 
+            slotN_(M_MAX_UNSIGNED), slotX_(M_MAX_UNSIGNED), slotY_(M_MAX_UNSIGNED),
+            versionN_(M_MAX_UNSIGNED), versionX_(M_MAX_UNSIGNED),
             ballCount_(0), numBallsShown_(0), dataSet_(false), 
-            minTime_(0.0f), maxTime_(0.0f), 
+            minTime_(0.0f), maxTime_(0.0f), clock_(0.0f),
             elapsedTimeAccum_(0.0f), limitFrameRate_(true)
         {
         }
@@ -525,32 +624,82 @@ void Main::CreateNodeGraph()
 
         void SetOutputConnection(OutputNode *outputNode)
         {
+            GraphPlan *graphPlan = GetSubsystem<GraphPlan>();
             outputNode_ = outputNode;
-            minTime_ = outputNode_->GetStartTime("Xi");
-            maxTime_ = outputNode_->GetEndTime("Xi");
+
+            // inputs are looked up by name once, the plan serves them by slot
+            unsigned node = outputNode_ ? outputNode_->GetModelNode() : M_MAX_UNSIGNED;
+            slotN_ = graphPlan->GetSlot(node, "Ni");
+            slotX_ = graphPlan->GetSlot(node, "Xi");
+            slotY_ = graphPlan->GetSlot(node, "Yi");
+
+            // re-read on the next update
+            versionN_ = M_MAX_UNSIGNED;
+            versionX_ = M_MAX_UNSIGNED;
         }
 
         void Start()
         {
+            PageManager *pageManager = GetSubsystem<PageManager>();
             elapsedTimeAccum_ = 0.0f;
 
-            SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(InputProcessor, HandleUpdate));
+            // only update while our page is shown
+            pageManager->AddPageActiveCallback(this, (PageActiveCallback)&InputProcessor::HandlePageActive);
+
+            if ( pageManager->IsPageActive(this) )
+            {
+                SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(InputProcessor, HandleUpdate));
+            }
+        }
+
+        void HandlePageActive(bool active)
+        {
+            if ( active )
+            {
+                elapsedTimeAccum_ = 0.0f;
+                timerFrame_.Reset();
+                SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(InputProcessor, HandleUpdate));
+            }
+            else
+            {
+                UnsubscribeFromEvent(E_UPDATE);
+            }
         }
 
         void HandleUpdate(StringHash eventType, VariantMap& eventData)
         {
             using namespace Update;
             float timeStep = eventData[P_TIMESTEP].GetFloat();
+            GraphPlan *graphPlan = GetSubsystem<GraphPlan>();
 
-            if ( !IsVisible() || !GetParent()->IsVisible() )
-                return;
+            // the plan pushes changes, only re-read what changed upstream
+            unsigned versionN = graphPlan->GetVersion(slotN_);
+
+            if ( versionN != versionN_ )
+            {
+                const Variant &var = graphPlan->GetCurrentValue(slotN_);
+                ballCount_ = 0;
+
+                if (var != Variant::EMPTY )
+                {
+                    ballCount_ = var.GetInt();
+                }
 
-            Variant var = outputNode_->GetCurrentValue("Ni");
-            ballCount_ = 0;
+                versionN_ = versionN;
 
-            if (var != Variant::EMPTY )
+                if (ballCount_ > 0)
+                {
+                    UpdateBallVis();
+                }
+            }
+
+            unsigned versionX = graphPlan->GetVersion(slotX_);
+
+            if ( versionX != versionX_ )
             {
-                ballCount_ = var.GetInt();
+                minTime_ = graphPlan->GetStartTime(slotX_);
+                maxTime_ = graphPlan->GetEndTime(slotX_);
+                versionX_ = versionX;
             }
 
             elapsedTimeAccum_ += timeStep;
@@ -559,8 +708,6 @@ void Main::CreateNodeGraph()
             {
                 if (ballCount_ > 0)
                 {
-                    UpdateBallVis();
-
                     UpdateBallPosition(elapsedTimeAccum_);
                 }
 
@@ -571,16 +718,36 @@ void Main::CreateNodeGraph()
 
         void UpdateBallPosition(float timeStep)
         {
-            for ( unsigned i = 0; i < numBallsShown_ && i < ballList_.Size(); ++i )
+            GraphPlan *graphPlan = GetSubsystem<GraphPlan>();
+            unsigned numBalls = Min(numBallsShown_, ballList_.Size());
+
+            clock_ += timeStep;
+
+            if ( numBalls == 0 )
+                return;
+
+            // every ball runs the same graph, they only differ in time
+            if ( instanceBatch_.GetNumInstances() != numBalls )
             {
-                ballList_[i].time += timeStep;
+                instanceBatch_.SetNumInstances(numBalls);
+
+                for ( unsigned i = 0; i < numBalls; ++i )
+                {
+                    instanceBatch_.SetTimeOffset(i, ballList_[i].timeOffset);
+                }
+            }
 
-                if ( ballList_[i].time > maxTime_) ballList_[i].time = 0.0f;
+            graphPlan->EvaluateInstances(instanceBatch_, clock_, maxTime_);
 
-                float x = outputNode_->GetValueAtTime("Xi", ballList_[i].time);
-                float y = outputNode_->GetValueAtTime("Yi", ballList_[i].time);
+            const float *x = instanceBatch_.GetValues(slotX_);
+            const float *y = instanceBatch_.GetValues(slotY_);
 
-                ballList_[i].sprite->SetPosition( ballList_[i].pos + Vector2(x, y) );
+            if ( x == NULL || y == NULL )
+                return;
+
+            for ( unsigned i = 0; i < numBalls; ++i )
+            {
+                ballList_[i].sprite->SetPosition( ballList_[i].pos + Vector2(x[i], y[i]) );
             }
         }
 
@@ -622,12 +789,14 @@ void Main::CreateNodeGraph()
             Texture2D *balltex2d = cache->GetResource<Texture2D>("Urho2D/Ball.png");
             SharedPtr<Sprite> sprite(new Sprite(context_));
             sprite->SetTexture(balltex2d);
+            sprite->SetTemporary(true);
 
             Vector2 pos( Vector2( 700 + Random() * 200, 350 + Random() * 200) );
 
             BallData bdata;
             bdata.sprite = sprite;
             bdata.pos = pos;
+            bdata.timeOffset = -clock_;     // starts at time 0
 
             sprite->SetPosition(pos);
             sprite->SetSize(IntVector2(32, 32));
@@ -643,13 +812,20 @@ void Main::CreateNodeGraph()
 
     protected:
         WeakPtr<OutputNode> outputNode_;
+        unsigned            slotN_;
+        unsigned            slotX_;
+        unsigned            slotY_;
+        unsigned            versionN_;
+        unsigned            versionX_;
         Vector<BallData>    ballList_;
+        GraphInstanceBatch  instanceBatch_;
         unsigned            ballCount_;
         unsigned            numBallsShown_;
 
         bool                dataSet_;
         float               minTime_;
         float               maxTime_;
+        float               clock_;
 
         float               elapsedTimeAccum_;
         bool                limitFrameRate_;
@@ -662,7 +838,7 @@ void Main::CreateNodeGraph()
     InputProcessor *inputProcessor = new InputProcessor(context_);
     root->AddChild(inputProcessor);
 
-    inputProcessor->SetOutputConnection(outNode2);
+    inputProcessor->SetOutputConnection(outputNode);
     inputProcessor->Start();
 }
 
@@ -29,6 +29,9 @@ namespace Urho3D
     class Node;
     class Scene;
 }
+class SlideVarNode;
+class OutputNode;
+class TabGroup;
 
 /// GUI test example.
 /// This sample demonstrates:
@@ -52,14 +55,22 @@ protected:
     /// Construct the GUI 
     void CreatePageManager();
     void CreateGUI();
+    void BuildControlsPage();
+    void BuildNodeGraphPage();
+    void BuildCanvasPage();
+    void RestoreNodeGraphPage();
     void CreateRadialGroup();
     void CreateTabGroup();
+    void BuildTabBody(TabGroup *tabGroup, unsigned idx);
     void CreateLineComponents();
     void CreateSpriteAnimBox();
     void CreateDrawTool();
+    void CreateCanvasDrawTool();
 
     void CreateSliderBarInput();
     void CreateNodeGraph();
+    void AttachColorCallback(SlideVarNode *slideVarNode);
+    void AttachInputProcessor(OutputNode *outputNode);
 
     /// Construct an instruction text to the UI.
     void CreateInstructions();
@@ -0,0 +1,247 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "GraphModel.h"
+
+#include <Urho3D/DebugNew.h>
+//=============================================================================
+//=============================================================================
+GraphModel::GraphModel()
+    : topologyVersion_(1)
+{
+}
+
+unsigned GraphModel::AddNode()
+{
+    if ( freeNodeList_.Size() )
+    {
+        unsigned node = freeNodeList_.Back();
+        freeNodeList_.Pop();
+        return node;
+    }
+
+    nodePortList_.Resize(nodePortList_.Size() + 1);
+
+    return nodePortList_.Size() - 1;
+}
+
+void GraphModel::RemoveNode(unsigned node)
+{
+    if ( node >= nodePortList_.Size() )
+        return;
+
+    // ports outlive their node until their owner removes them
+    PODVector<unsigned> &ports = nodePortList_[node];
+
+    for ( unsigned i = 0; i < ports.Size(); ++i )
+    {
+        portList_[ports[i]].node_ = M_MAX_UNSIGNED;
+    }
+
+    ports.Clear();
+
+    // node ids are reused, inputs still naming this one would bind to the next node
+    for ( unsigned i = 0; i < portList_.Size(); ++i )
+    {
+        GraphPort &graphPort = portList_[i];
+
+        if ( graphPort.type_ == PORTTYPE_INPUT && graphPort.connectNode_ == node )
+        {
+            graphPort.connectNode_ = M_MAX_UNSIGNED;
+            graphPort.connectName_.Clear();
+        }
+    }
+
+    freeNodeList_.Push(node);
+    ++topologyVersion_;
+}
+
+unsigned GraphModel::AddPort(unsigned node, GraphPortType type, const String &name)
+{
+    unsigned port;
+
+    if ( freePortList_.Size() )
+    {
+        port = freePortList_.Back();
+        freePortList_.Pop();
+    }
+    else
+    {
+        port = portList_.Size();
+        portList_.Resize(port + 1);
+    }
+
+    GraphPort &graphPort = portList_[port];
+    graphPort = GraphPort();
+    graphPort.type_ = type;
+    graphPort.node_ = node;
+    graphPort.name_ = name;
+
+    if ( node < nodePortList_.Size() )
+    {
+        nodePortList_[node].Push(port);
+    }
+
+    ++topologyVersion_;
+
+    return port;
+}
+
+void GraphModel::RemovePort(unsigned port)
+{
+    if ( port >= portList_.Size() || portList_[port].type_ == PORTTYPE_NONE )
+        return;
+
+    GraphPort &graphPort = portList_[port];
+
+    if ( graphPort.node_ < nodePortList_.Size() )
+    {
+        nodePortList_[graphPort.node_].Remove(port);
+    }
+
+    graphPort = GraphPort();
+    freePortList_.Push(port);
+    ++topologyVersion_;
+}
+
+void GraphModel::SetPortName(unsigned port, const String &name)
+{
+    if ( port >= portList_.Size() || portList_[port].type_ == PORTTYPE_NONE )
+        return;
+
+    // connections are resolved by name
+    portList_[port].name_ = name;
+    ++topologyVersion_;
+}
+
+unsigned GraphModel::FindPort(unsigned node, const String &name) const
+{
+    if ( node >= nodePortList_.Size() )
+        return M_MAX_UNSIGNED;
+
+    const PODVector<unsigned> &ports = nodePortList_[node];
+
+    for ( unsigned i = 0; i < ports.Size(); ++i )
+    {
+        if ( portList_[ports[i]].name_ == name )
+            return ports[i];
+    }
+
+    return M_MAX_UNSIGNED;
+}
+
+GraphPort* GraphModel::GetTypedPort(unsigned port, GraphPortType type)
+{
+    return port < portList_.Size() && portList_[port].type_ == type ? &portList_[port] : NULL;
+}
+
+void GraphModel::MarkChanged(unsigned port)
+{
+    // a slider drag changes the same port many times between reads
+    if ( !portList_[port].changeQueued_ )
+    {
+        portList_[port].changeQueued_ = true;
+        changedPortList_.Push(port);
+    }
+}
+
+void GraphModel::ClearChangedPorts()
+{
+    for ( unsigned i = 0; i < changedPortList_.Size(); ++i )
+    {
+        portList_[changedPortList_[i]].changeQueued_ = false;
+    }
+
+    changedPortList_.Clear();
+}
+
+void GraphModel::SetCurve(unsigned port, const PODVector<float> &times, const PODVector<float> &values,
+                          float timeStart, float timeEnd)
+{
+    GraphPort *graphPort = GetTypedPort(port, PORTTYPE_CURVE);
+
+    if ( graphPort )
+    {
+        graphPort->curve_.SetKeys(times, values);
+        graphPort->curve_.SetTimeRange(timeStart, timeEnd);
+        MarkChanged(port);
+    }
+}
+
+void GraphModel::SetCurveResolution(unsigned port, unsigned resolution)
+{
+    GraphPort *graphPort = GetTypedPort(port, PORTTYPE_CURVE);
+
+    if ( graphPort )
+    {
+        graphPort->curve_.SetResolution(resolution);
+        MarkChanged(port);
+    }
+}
+
+const TimeCurve* GraphModel::GetCurve(unsigned port) const
+{
+    return port < portList_.Size() && portList_[port].type_ == PORTTYPE_CURVE ? &portList_[port].curve_ : NULL;
+}
+
+void GraphModel::SetValue(unsigned port, const Variant &value)
+{
+    GraphPort *graphPort = GetTypedPort(port, PORTTYPE_VALUE);
+
+    if ( graphPort && graphPort->value_ != value )
+    {
+        graphPort->value_ = value;
+        MarkChanged(port);
+    }
+}
+
+const Variant& GraphModel::GetValue(unsigned port) const
+{
+    return port < portList_.Size() && portList_[port].type_ == PORTTYPE_VALUE ? portList_[port].value_ : Variant::EMPTY;
+}
+
+void GraphModel::Connect(unsigned port, unsigned node, const String &name)
+{
+    GraphPort *graphPort = GetTypedPort(port, PORTTYPE_INPUT);
+
+    if ( graphPort )
+    {
+        graphPort->connectNode_ = node;
+        graphPort->connectName_ = name;
+        ++topologyVersion_;
+    }
+}
+
+void GraphModel::SetBlockMode(unsigned port, bool block)
+{
+    GraphPort *graphPort = GetTypedPort(port, PORTTYPE_INPUT);
+
+    if ( graphPort && graphPort->block_ != block )
+    {
+        graphPort->block_ = block;
+        ++topologyVersion_;
+    }
+}
+
+const GraphPort* GraphModel::GetPort(unsigned port) const
+{
+    return port < portList_.Size() && portList_[port].type_ != PORTTYPE_NONE ? &portList_[port] : NULL;
+}
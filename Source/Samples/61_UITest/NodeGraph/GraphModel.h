@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+#include <Urho3D/Core/Variant.h>
+#include <Urho3D/Container/Str.h>
+
+#include "TimeCurve.h"
+
+using namespace Urho3D;
+//=============================================================================
+//=============================================================================
+enum GraphPortType
+{
+    PORTTYPE_NONE,
+    PORTTYPE_CURVE,     // value over time, a TimeCurve
+    PORTTYPE_VALUE,     // single value, a slider
+    PORTTYPE_INPUT      // reads the port of another node it's connected to
+};
+
+struct GraphPort
+{
+    GraphPort() : type_(PORTTYPE_NONE), node_(M_MAX_UNSIGNED), connectNode_(M_MAX_UNSIGNED), block_(false), changeQueued_(false) {}
+
+    GraphPortType type_;
+    unsigned      node_;
+    String        name_;
+
+    Variant       value_;           // PORTTYPE_VALUE
+    TimeCurve     curve_;           // PORTTYPE_CURVE
+
+    // PORTTYPE_INPUT, the port named connectName_ on connectNode_. a block
+    // connection carries a buffer of samples per evaluation, see GraphPlan
+    unsigned      connectNode_;
+    String        connectName_;
+    bool          block_;
+
+    bool          changeQueued_;
+};
+
+//=============================================================================
+// the node graph as plain data: nodes are ids, ports are named inputs of a
+// node holding a curve, a value or a connection to another node's port.
+// nothing here knows about UIElements, the node graph widgets are views that
+// write their edits into the model, GraphPlan compiles and evaluates it.
+// edits are recorded for GraphPlan: connection and naming changes bump the
+// topology version, curve and value edits queue the port as changed.
+//=============================================================================
+class GraphModel
+{
+public:
+    GraphModel();
+
+    unsigned AddNode();
+    void RemoveNode(unsigned node);
+
+    unsigned AddPort(unsigned node, GraphPortType type, const String &name);
+    void RemovePort(unsigned port);
+    void SetPortName(unsigned port, const String &name);
+
+    // first port named name on the node, M_MAX_UNSIGNED if not found
+    unsigned FindPort(unsigned node, const String &name) const;
+
+    void SetCurve(unsigned port, const PODVector<float> &times, const PODVector<float> &values,
+                  float timeStart, float timeEnd);
+    void SetCurveResolution(unsigned port, unsigned resolution);
+    const TimeCurve* GetCurve(unsigned port) const;
+
+    void SetValue(unsigned port, const Variant &value);
+    const Variant& GetValue(unsigned port) const;
+
+    void Connect(unsigned port, unsigned node, const String &name);
+    void Disconnect(unsigned port) { Connect(port, M_MAX_UNSIGNED, String::EMPTY); }
+    void SetBlockMode(unsigned port, bool block);
+
+    // NULL for a removed port
+    const GraphPort* GetPort(unsigned port) const;
+    unsigned GetNumPorts() const                    { return portList_.Size(); }
+
+    // change tracking
+    unsigned GetTopologyVersion() const             { return topologyVersion_; }
+    const PODVector<unsigned>& GetChangedPorts() const { return changedPortList_; }
+    void ClearChangedPorts();
+
+protected:
+    GraphPort* GetTypedPort(unsigned port, GraphPortType type);
+    void MarkChanged(unsigned port);
+
+protected:
+    Vector<GraphPort>           portList_;
+    PODVector<unsigned>         freePortList_;
+
+    // ports of each node
+    Vector<PODVector<unsigned> > nodePortList_;
+    PODVector<unsigned>         freeNodeList_;
+
+    unsigned                    topologyVersion_;
+    PODVector<unsigned>         changedPortList_;
+};
@@ -35,6 +35,7 @@
 #include "GraphNode.h"
 #include "PageManager.h"
 #include "InputNodeManager.h"
+#include "GraphPlan.h"
 #include "InputNode.h"
 #include "OutputNode.h"
 #include "SlideVarInput.h"
@@ -55,10 +56,12 @@ IntVector2 GraphNode::ioNodeSize_(25, 25);
 void GraphNode::RegisterObject(Context* context)
 {
     context->RegisterFactory<GraphNode>(UI_CATEGORY);
+    URHO3D_COPY_BASE_ATTRIBUTES(BorderImage);
 
     // register all node graph components
     NodeHeader::RegisterObject(context);
     InputNodeManager::RegisterObject(context);
+    GraphPlan::RegisterObject(context);
 
     // io elements
     IOElement::RegisterObject(context);
@@ -79,11 +82,17 @@ GraphNode::GraphNode(Context *context)
 {
     UIElement::SetEnabled(false);
 
+    modelNode_ = GetSubsystem<GraphPlan>()->GetModel().AddNode();
+
     InitInternal();
 }
 
 GraphNode::~GraphNode()
 {
+    GraphPlan *graphPlan = GetSubsystem<GraphPlan>();
+
+    if ( graphPlan )
+        graphPlan->GetModel().RemoveNode(modelNode_);
 }
 
 bool GraphNode::InitInternal()
@@ -159,6 +168,23 @@ void GraphNode::AddChild(UIElement* element)
     }
 }
 
+UIElement* GraphNode::FindIOElement(StringHash type)
+{
+    // io elements restored from a page snapshot live in the body containers
+    PODVector<UIElement*> children;
+    GetChildren(children, true);
+
+    for ( unsigned i = 0; i < children.Size(); ++i )
+    {
+        if ( children[i]->GetType() == type )
+        {
+            return children[i];
+        }
+    }
+
+    return NULL;
+}
+
 void GraphNode::SetEnabled(bool enable)
 {
     /// disabled - use the header instead
@@ -270,6 +296,7 @@ void GraphNode::OnDragEnd(const IntVector2& position, const IntVector2& screenPo
 void NodeHeader::RegisterObject(Context* context)
 {
     context->RegisterFactory<NodeHeader>(UI_CATEGORY);
+    URHO3D_COPY_BASE_ATTRIBUTES(BorderImage);
 }
 
 NodeHeader::NodeHeader(Context *context)
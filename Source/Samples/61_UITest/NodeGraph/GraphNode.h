@@ -83,6 +83,9 @@ public:
 
     void SetEnabled(bool enable);
 
+    // node id in the GraphPlan model
+    unsigned GetModelNode() const { return modelNode_; }
+
     // related to timevar input
     virtual float GetValueRangeMin(const String &varName);
     virtual float GetValueRangeMax(const String &varName);
@@ -108,6 +111,7 @@ public:
 
 protected:
     IOElement* FindInuptVarName(const String &varName);
+    UIElement* FindIOElement(StringHash type);
 
 private:
     bool InitInternal();
@@ -132,6 +136,7 @@ protected:
     WeakPtr<Text>         footerText_;
 
     bool                  footerToggle_;
+    unsigned              modelNode_;
 
     IntVector2            dragBeginPosition_;
     IntVector2            dragBeginCursor_;
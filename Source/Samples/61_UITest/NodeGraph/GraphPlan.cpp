@@ -0,0 +1,722 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+#include "GraphPlan.h"
+
+#include <math.h>
+
+#include <Urho3D/DebugNew.h>
+//=============================================================================
+//=============================================================================
+#define PARALLEL_MIN_STEPS  256     // smaller levels run on the main thread
+#define STEPS_PER_TASK      32
+#define INSTANCES_PER_TASK  1024
+#define DEFAULT_BLOCK_SIZE  64
+
+//=============================================================================
+//=============================================================================
+enum PortVisitState
+{
+    PORT_UNVISITED,
+    PORT_VISITING,
+    PORT_RESOLVED
+};
+
+//=============================================================================
+//=============================================================================
+void GraphInstanceBatch::SetNumInstances(unsigned numInstances)
+{
+    unsigned prevInstances = numInstances_;
+
+    numInstances_ = numInstances;
+    timeOffset_.Resize(numInstances);
+    time_.Resize(numInstances);
+
+    for ( unsigned i = prevInstances; i < numInstances; ++i )
+        timeOffset_[i] = 0.0f;
+
+    // added instances start without an override
+    for ( HashMap<unsigned, InstanceOverride>::Iterator it = overrides_.Begin(); it != overrides_.End(); ++it )
+    {
+        it->second_.values_.Resize(numInstances);
+        it->second_.mask_.Resize(numInstances);
+
+        for ( unsigned i = prevInstances; i < numInstances; ++i )
+        {
+            it->second_.values_[i] = 0.0f;
+            it->second_.mask_[i] = 0.0f;
+        }
+    }
+
+    // the lanes are rebuilt by the next evaluation
+    numPorts_ = 0;
+    values_.Clear();
+}
+
+void GraphInstanceBatch::SetOverride(unsigned slot, unsigned instance, float value)
+{
+    assert(instance < numInstances_ && "set the number of instances first");
+
+    InstanceOverride &instanceOverride = overrides_[slot];
+
+    if ( instanceOverride.mask_.Size() != numInstances_ )
+    {
+        instanceOverride.values_.Resize(numInstances_);
+        instanceOverride.mask_.Resize(numInstances_);
+
+        for ( unsigned i = 0; i < numInstances_; ++i )
+        {
+            instanceOverride.values_[i] = 0.0f;
+            instanceOverride.mask_[i] = 0.0f;
+        }
+    }
+
+    instanceOverride.values_[instance] = value;
+    instanceOverride.mask_[instance] = 1.0f;
+}
+
+const float* GraphInstanceBatch::GetValues(unsigned slot) const
+{
+    return slot < numPorts_ && numInstances_ ? &values_[slot * numInstances_] : NULL;
+}
+
+//=============================================================================
+//=============================================================================
+void GraphPlan::RegisterObject(Context* context)
+{
+    context->RegisterSubsystem( new GraphPlan(context) );
+}
+
+GraphPlan::GraphPlan(Context *context)
+    : Object(context)
+    , compiledVersion_(0)
+    , evalTime_(0.0f)
+    , evalTimeChanged_(false)
+    , evalBatch_(NULL)
+    , blockSize_(DEFAULT_BLOCK_SIZE)
+    , lastEvalTime_(0.0f)
+    , evaluated_(false)
+{
+}
+
+GraphPlan::~GraphPlan()
+{
+}
+
+bool GraphPlan::Compile()
+{
+    if ( compiledVersion_ == model_.GetTopologyVersion() )
+        return false;
+
+    unsigned numPorts = model_.GetNumPorts();
+    unsigned numVersions = portVersion_.Size();
+
+    steps_.Clear();
+    sourcePort_.Resize(numPorts);
+    visitState_.Resize(numPorts);
+    values_.Resize(numPorts);
+    stale_.Resize(numPorts);
+    portVersion_.Resize(numPorts);
+
+    for ( unsigned i = 0; i < numPorts; ++i )
+    {
+        sourcePort_[i] = M_MAX_UNSIGNED;
+        visitState_[i] = PORT_UNVISITED;
+        values_[i] = 0.0f;
+        stale_[i] = 1;
+
+        // any connection may have changed, every reader has to look again
+        portVersion_[i] = i < numVersions ? portVersion_[i] + 1 : 1;
+    }
+
+    // depth first, a port's step is emitted after the port it reads from
+    for ( unsigned i = 0; i < numPorts; ++i )
+    {
+        ResolvePort(i);
+    }
+
+    BuildDependents();
+    BuildLevels();
+    BuildBlocks();
+
+    publishedValues_ = values_;
+    evaluated_ = false;
+    compiledVersion_ = model_.GetTopologyVersion();
+
+    return true;
+}
+
+void GraphPlan::BuildDependents()
+{
+    unsigned numPorts = model_.GetNumPorts();
+
+    dependentStart_.Resize(numPorts + 1);
+
+    for ( unsigned i = 0; i <= numPorts; ++i )
+        dependentStart_[i] = 0;
+
+    // count, prefix sum, then fill
+    for ( unsigned i = 0; i < steps_.Size(); ++i )
+    {
+        if ( steps_[i].op_ == PLANOP_COPY )
+            ++dependentStart_[steps_[i].src_ + 1];
+    }
+
+    for ( unsigned i = 0; i < numPorts; ++i )
+        dependentStart_[i + 1] += dependentStart_[i];
+
+    dependentList_.Resize(dependentStart_[numPorts]);
+    PODVector<unsigned> fill(dependentStart_);
+
+    for ( unsigned i = 0; i < steps_.Size(); ++i )
+    {
+        if ( steps_[i].op_ == PLANOP_COPY )
+            dependentList_[fill[steps_[i].src_]++] = steps_[i].dst_;
+    }
+}
+
+void GraphPlan::BuildLevels()
+{
+    unsigned numSteps = steps_.Size();
+    unsigned numLevels = 0;
+
+    // sources are level 0, a copy is one above the port it reads. the steps
+    // are in dependency order so a single pass sees every source first
+    PODVector<unsigned> portLevel(model_.GetNumPorts());
+    stepLevel_.Resize(numSteps);
+
+    for ( unsigned i = 0; i < numSteps; ++i )
+    {
+        const PlanStep &step = steps_[i];
+        unsigned level = step.op_ == PLANOP_COPY ? portLevel[step.src_] + 1 : 0;
+
+        portLevel[step.dst_] = level;
+        stepLevel_[i] = level;
+        numLevels = Max(numLevels, level + 1);
+    }
+
+    // stable counting sort of the steps by level
+    levelStart_.Resize(numLevels + 1);
+
+    for ( unsigned i = 0; i <= numLevels; ++i )
+        levelStart_[i] = 0;
+
+    for ( unsigned i = 0; i < numSteps; ++i )
+        ++levelStart_[stepLevel_[i] + 1];
+
+    for ( unsigned i = 0; i < numLevels; ++i )
+        levelStart_[i + 1] += levelStart_[i];
+
+    PODVector<unsigned> fill(levelStart_);
+    PODVector<PlanStep> sorted(numSteps);
+
+    for ( unsigned i = 0; i < numSteps; ++i )
+        sorted[fill[stepLevel_[i]]++] = steps_[i];
+
+    steps_ = sorted;
+}
+
+void GraphPlan::BuildBlocks()
+{
+    unsigned numPorts = model_.GetNumPorts();
+    unsigned numBlockPorts = 0;
+    PODVector<unsigned char> isBlock(numPorts);
+    PODVector<unsigned char> isDownstream(numPorts);
+
+    for ( unsigned i = 0; i < numPorts; ++i )
+    {
+        const GraphPort *graphPort = model_.GetPort(i);
+        isBlock[i] = graphPort && graphPort->block_ ? 1 : 0;
+        isDownstream[i] = isBlock[i];
+    }
+
+    // the source side of a block connection produces blocks, walk back from
+    // the last step so a chain of copies is marked in one pass
+    for ( int i = (int)steps_.Size() - 1; i >= 0; --i )
+    {
+        if ( steps_[i].op_ == PLANOP_COPY && isBlock[steps_[i].dst_] )
+            isBlock[steps_[i].src_] = 1;
+    }
+
+    // and whatever reads a block input gets the block too, scalar readers of
+    // the same upstream source stay scalar
+    for ( unsigned i = 0; i < steps_.Size(); ++i )
+    {
+        if ( steps_[i].op_ == PLANOP_COPY && isDownstream[steps_[i].src_] )
+        {
+            isDownstream[steps_[i].dst_] = 1;
+            isBlock[steps_[i].dst_] = 1;
+        }
+    }
+
+    blockOffset_.Resize(numPorts);
+    blockStepList_.Clear();
+
+    for ( unsigned i = 0; i < numPorts; ++i )
+    {
+        blockOffset_[i] = isBlock[i] ? blockSize_ * numBlockPorts++ : M_MAX_UNSIGNED;
+    }
+
+    for ( unsigned i = 0; i < steps_.Size(); ++i )
+    {
+        if ( isBlock[steps_[i].dst_] )
+            blockStepList_.Push(i);
+    }
+
+    blockValues_.Resize(blockSize_ * numBlockPorts);
+
+    for ( unsigned i = 0; i < blockValues_.Size(); ++i )
+        blockValues_[i] = 0.0f;
+}
+
+void GraphPlan::Sync()
+{
+    // a recompile already marked everything
+    if ( !Compile() )
+    {
+        const PODVector<unsigned> &changedPorts = model_.GetChangedPorts();
+
+        for ( unsigned i = 0; i < changedPorts.Size(); ++i )
+        {
+            PushChanged(changedPorts[i]);
+        }
+    }
+
+    model_.ClearChangedPorts();
+}
+
+void GraphPlan::PushChanged(unsigned port)
+{
+    // the plan has no loops, each downstream port is reached through one path per edge
+    pushStack_.Clear();
+    pushStack_.Push(port);
+
+    while ( pushStack_.Size() )
+    {
+        unsigned p = pushStack_.Back();
+        pushStack_.Pop();
+
+        ++portVersion_[p];
+        stale_[p] = 1;
+
+        for ( unsigned i = dependentStart_[p]; i < dependentStart_[p + 1]; ++i )
+        {
+            pushStack_.Push(dependentList_[i]);
+        }
+    }
+}
+
+unsigned GraphPlan::GetVersion(unsigned slot)
+{
+    Sync();
+
+    return slot < portVersion_.Size() ? portVersion_[slot] : 0;
+}
+
+bool GraphPlan::ResolvePort(unsigned port)
+{
+    if ( visitState_[port] == PORT_RESOLVED )
+        return sourcePort_[port] != M_MAX_UNSIGNED;
+
+    // a connection loop, leave the ports in it unconnected
+    if ( visitState_[port] == PORT_VISITING )
+        return false;
+
+    const GraphPort *graphPort = model_.GetPort(port);
+    visitState_[port] = PORT_VISITING;
+
+    if ( graphPort == NULL )
+    {
+    }
+    else if ( graphPort->type_ == PORTTYPE_CURVE )
+    {
+        PlanStep step = { PLANOP_CURVE, port, port };
+        steps_.Push(step);
+        sourcePort_[port] = port;
+    }
+    else if ( graphPort->type_ == PORTTYPE_VALUE )
+    {
+        PlanStep step = { PLANOP_VALUE, port, port };
+        steps_.Push(step);
+        sourcePort_[port] = port;
+    }
+    else if ( graphPort->type_ == PORTTYPE_INPUT )
+    {
+        unsigned src = model_.FindPort(graphPort->connectNode_, graphPort->connectName_);
+
+        if ( src != M_MAX_UNSIGNED && src != port && ResolvePort(src) )
+        {
+            PlanStep step = { PLANOP_COPY, port, src };
+            steps_.Push(step);
+            sourcePort_[port] = sourcePort_[src];
+        }
+    }
+
+    visitState_[port] = PORT_RESOLVED;
+
+    return sourcePort_[port] != M_MAX_UNSIGNED;
+}
+
+const TimeCurve* GraphPlan::GetCurveSource(unsigned slot)
+{
+    Compile();
+
+    if ( slot >= sourcePort_.Size() || sourcePort_[slot] == M_MAX_UNSIGNED )
+        return NULL;
+
+    return model_.GetCurve(sourcePort_[slot]);
+}
+
+unsigned GraphPlan::GetValueSource(unsigned slot)
+{
+    Compile();
+
+    return slot < sourcePort_.Size() ? sourcePort_[slot] : M_MAX_UNSIGNED;
+}
+
+float GraphPlan::GetValueAtTime(unsigned slot, float time)
+{
+    const TimeCurve *curve = GetCurveSource(slot);
+
+    return curve ? curve->Sample(time) : 0.0f;
+}
+
+void GraphPlan::SampleRange(unsigned slot, const float *times, float *out, unsigned n)
+{
+    const TimeCurve *curve = GetCurveSource(slot);
+
+    if ( curve )
+    {
+        curve->SampleRange(times, out, n);
+    }
+    else
+    {
+        for ( unsigned i = 0; i < n; ++i )
+            out[i] = 0.0f;
+    }
+}
+
+float GraphPlan::GetStartTime(unsigned slot)
+{
+    const TimeCurve *curve = GetCurveSource(slot);
+
+    return curve ? curve->GetTimeStart() : 0.0f;
+}
+
+float GraphPlan::GetEndTime(unsigned slot)
+{
+    const TimeCurve *curve = GetCurveSource(slot);
+
+    return curve ? curve->GetTimeEnd() : 0.0f;
+}
+
+const Variant& GraphPlan::GetCurrentValue(unsigned slot)
+{
+    return model_.GetValue(GetValueSource(slot));
+}
+
+void GraphPlan::Evaluate(float time)
+{
+    Sync();
+
+    WorkQueue *queue = GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads() > 0;
+
+    evalTime_ = time;
+    evalTimeChanged_ = !evaluated_ || time != lastEvalTime_;
+
+    // a level only reads lower levels, so the steps inside it are independent.
+    // big levels go out in many small chunks, the pool threads (and the main
+    // thread in Complete()) take the next chunk as soon as they're free, which
+    // evens out uneven step costs
+    for ( unsigned l = 0; l + 1 < levelStart_.Size(); ++l )
+    {
+        unsigned first = levelStart_[l];
+        unsigned last = levelStart_[l + 1];
+
+        if ( !threaded || last - first < PARALLEL_MIN_STEPS )
+        {
+            EvaluateSteps(first, last);
+            continue;
+        }
+
+        for ( unsigned start = first; start < last; start += STEPS_PER_TASK )
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = EvaluateStepsWork;
+            item->aux_ = this;
+            item->start_ = (void*)(size_t)start;
+            item->end_ = (void*)(size_t)Min(start + STEPS_PER_TASK, last);
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    for ( unsigned i = 0; i < steps_.Size(); ++i )
+    {
+        stale_[steps_[i].dst_] = 0;
+    }
+
+    // publish
+    publishedValues_ = values_;
+
+    lastEvalTime_ = time;
+    evaluated_ = true;
+}
+
+void GraphPlan::EvaluateStepsWork(const WorkItem *item, unsigned threadIndex)
+{
+    GraphPlan *plan = static_cast<GraphPlan*>(item->aux_);
+
+    plan->EvaluateSteps((unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+void GraphPlan::EvaluateSteps(unsigned first, unsigned last)
+{
+    // a copy sees whether its source was recomputed in this pass through the
+    // source's stale flag, the flags are cleared once the whole pass is done.
+    // every step writes only its own dst port
+    for ( unsigned i = first; i < last; ++i )
+    {
+        const PlanStep &step = steps_[i];
+        bool update = stale_[step.dst_] != 0;
+
+        switch ( step.op_ )
+        {
+        case PLANOP_CURVE:
+            update = update || evalTimeChanged_;
+            if ( update )
+                values_[step.dst_] = model_.GetCurve(step.src_)->Sample(evalTime_);
+            break;
+
+        case PLANOP_VALUE:
+            if ( update )
+                values_[step.dst_] = model_.GetValue(step.src_).GetFloat();
+            break;
+
+        case PLANOP_COPY:
+            update = update || stale_[step.src_] != 0;
+            if ( update )
+                values_[step.dst_] = values_[step.src_];
+            break;
+        }
+
+        stale_[step.dst_] = update;
+    }
+}
+
+void GraphPlan::EvaluateInstances(GraphInstanceBatch &batch, float time, float loopTime)
+{
+    Sync();
+
+    unsigned numInstances = batch.numInstances_;
+    unsigned numPorts = model_.GetNumPorts();
+
+    if ( numInstances == 0 )
+        return;
+
+    // ports without a step read as 0, a recompile can leave a port without
+    // its step so the lanes are cleared whenever the plan changes
+    if ( batch.numPorts_ != numPorts || batch.compiledVersion_ != compiledVersion_ )
+    {
+        batch.numPorts_ = numPorts;
+        batch.compiledVersion_ = compiledVersion_;
+        batch.values_.Resize(numPorts * numInstances);
+
+        for ( unsigned i = 0; i < batch.values_.Size(); ++i )
+            batch.values_[i] = 0.0f;
+    }
+
+    float *instanceTime = &batch.time_[0];
+    const float *timeOffset = &batch.timeOffset_[0];
+
+    for ( unsigned i = 0; i < numInstances; ++i )
+    {
+        instanceTime[i] = time + timeOffset[i];
+    }
+
+    if ( loopTime > 0.0f )
+    {
+        for ( unsigned i = 0; i < numInstances; ++i )
+        {
+            float t = fmodf(instanceTime[i], loopTime);
+            instanceTime[i] = t < 0.0f ? t + loopTime : t;
+        }
+    }
+
+    WorkQueue *queue = GetSubsystem<WorkQueue>();
+
+    if ( !queue || queue->GetNumThreads() == 0 || numInstances < INSTANCES_PER_TASK * 2 )
+    {
+        EvaluateInstanceRange(batch, 0, numInstances);
+        return;
+    }
+
+    // each chunk runs the whole plan over its own instances, no level barriers
+    evalBatch_ = &batch;
+
+    for ( unsigned start = 0; start < numInstances; start += INSTANCES_PER_TASK )
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = EvaluateInstancesWork;
+        item->aux_ = this;
+        item->start_ = (void*)(size_t)start;
+        item->end_ = (void*)(size_t)Min(start + INSTANCES_PER_TASK, numInstances);
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+
+    evalBatch_ = NULL;
+}
+
+void GraphPlan::EvaluateInstancesWork(const WorkItem *item, unsigned threadIndex)
+{
+    GraphPlan *plan = static_cast<GraphPlan*>(item->aux_);
+
+    plan->EvaluateInstanceRange(*plan->evalBatch_, (unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+void GraphPlan::EvaluateInstanceRange(GraphInstanceBatch &batch, unsigned first, unsigned last)
+{
+    const unsigned numInstances = batch.numInstances_;
+    const unsigned count = last - first;
+    const float *instanceTime = &batch.time_[first];
+    bool hasOverrides = !batch.overrides_.Empty();
+
+    // the steps are in dependency order, each one fills its port's lane
+    for ( unsigned s = 0; s < steps_.Size(); ++s )
+    {
+        const PlanStep &step = steps_[s];
+        float *dst = &batch.values_[step.dst_ * numInstances + first];
+
+        switch ( step.op_ )
+        {
+        case PLANOP_CURVE:
+            model_.GetCurve(step.src_)->SampleRange(instanceTime, dst, count);
+            break;
+
+        case PLANOP_VALUE:
+            {
+                float value = model_.GetValue(step.src_).GetFloat();
+
+                for ( unsigned i = 0; i < count; ++i )
+                    dst[i] = value;
+            }
+            break;
+
+        case PLANOP_COPY:
+            {
+                const float *src = &batch.values_[step.src_ * numInstances + first];
+
+                for ( unsigned i = 0; i < count; ++i )
+                    dst[i] = src[i];
+            }
+            break;
+        }
+
+        if ( hasOverrides )
+        {
+            HashMap<unsigned, InstanceOverride>::ConstIterator it = batch.overrides_.Find(step.dst_);
+
+            if ( it != batch.overrides_.End() )
+            {
+                const float *values = &it->second_.values_[first];
+                const float *mask = &it->second_.mask_[first];
+
+                // select without branching
+                for ( unsigned i = 0; i < count; ++i )
+                    dst[i] += (values[i] - dst[i]) * mask[i];
+            }
+        }
+    }
+}
+
+void GraphPlan::SetBlockSize(unsigned blockSize)
+{
+    if ( blockSize == 0 || blockSize == blockSize_ )
+        return;
+
+    blockSize_ = blockSize;
+
+    // buffers are laid out by the block size
+    if ( compiledVersion_ == model_.GetTopologyVersion() )
+        BuildBlocks();
+}
+
+const float* GraphPlan::GetBlock(unsigned slot) const
+{
+    if ( slot >= blockOffset_.Size() || blockOffset_[slot] == M_MAX_UNSIGNED )
+        return NULL;
+
+    return &blockValues_[blockOffset_[slot]];
+}
+
+void GraphPlan::EvaluateBlock(float startTime, float sampleInterval)
+{
+    // the scalar pass also compiles
+    Evaluate(startTime);
+
+    blockTime_.Resize(blockSize_);
+
+    for ( unsigned i = 0; i < blockSize_; ++i )
+    {
+        blockTime_[i] = startTime + sampleInterval * (float)i;
+    }
+
+    // one dispatch per step, each step processes its whole block
+    for ( unsigned s = 0; s < blockStepList_.Size(); ++s )
+    {
+        const PlanStep &step = steps_[blockStepList_[s]];
+        float *dst = &blockValues_[blockOffset_[step.dst_]];
+
+        switch ( step.op_ )
+        {
+        case PLANOP_CURVE:
+            model_.GetCurve(step.src_)->SampleRange(&blockTime_[0], dst, blockSize_);
+            break;
+
+        case PLANOP_VALUE:
+            {
+                float value = values_[step.dst_];
+
+                for ( unsigned i = 0; i < blockSize_; ++i )
+                    dst[i] = value;
+            }
+            break;
+
+        case PLANOP_COPY:
+            {
+                const float *src = &blockValues_[blockOffset_[step.src_]];
+
+                for ( unsigned i = 0; i < blockSize_; ++i )
+                    dst[i] = src[i];
+            }
+            break;
+        }
+    }
+}
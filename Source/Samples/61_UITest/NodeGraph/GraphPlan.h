@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Variant.h>
+#include <Urho3D/Container/HashMap.h>
+
+#include "GraphModel.h"
+
+namespace Urho3D
+{
+struct WorkItem;
+}
+
+using namespace Urho3D;
+//=============================================================================
+//=============================================================================
+enum PlanOp
+{
+    PLANOP_CURVE,       // sample a curve port at the evaluation time
+    PLANOP_VALUE,       // current value of a value port
+    PLANOP_COPY         // input port, forwards the port it's connected to
+};
+
+struct PlanStep
+{
+    PlanOp   op_;
+    unsigned dst_;
+    unsigned src_;
+};
+
+//=============================================================================
+// per instance state for GraphPlan::EvaluateInstances(), owned by the caller.
+// laid out as structure of arrays, every port gets a lane of one float per
+// instance so a step processes the whole batch in one loop
+//=============================================================================
+struct InstanceOverride
+{
+    PODVector<float>  values_;
+    PODVector<float>  mask_;        // 1 where the instance is overridden
+};
+
+class GraphInstanceBatch
+{
+public:
+    GraphInstanceBatch() : numInstances_(0), numPorts_(0), compiledVersion_(0) {}
+
+    void SetNumInstances(unsigned numInstances);
+    unsigned GetNumInstances() const { return numInstances_; }
+
+    // instance time is the evaluation time plus the offset
+    void SetTimeOffset(unsigned instance, float offset) { timeOffset_[instance] = offset; }
+    float GetTimeOffset(unsigned instance) const        { return timeOffset_[instance]; }
+
+    // replaces the value a port computes for one instance, the ports
+    // downstream of it see the override
+    void SetOverride(unsigned slot, unsigned instance, float value);
+    void ClearOverrides(unsigned slot) { overrides_.Erase(slot); }
+
+    // numInstances values, NULL before the first evaluation or for a bad slot
+    const float* GetValues(unsigned slot) const;
+
+protected:
+    friend class GraphPlan;
+
+    unsigned                             numInstances_;
+    unsigned                             numPorts_;
+    unsigned                             compiledVersion_;   // plan the lanes were filled by
+    PODVector<float>                     timeOffset_;
+    PODVector<float>                     time_;
+    PODVector<float>                     values_;       // values_[port * numInstances_ + instance]
+    HashMap<unsigned, InstanceOverride>  overrides_;
+};
+
+//=============================================================================
+// the GraphModel compiled into a flat list of steps over its integer ports,
+// an input port resolves to the port it's connected to by node and name. The
+// plan is recompiled lazily after the model's topology changes, queries go
+// straight to the resolved source without string lookups. it needs no UI, a
+// headless process can build a model through GetModel() and evaluate it.
+// changes are pushed: an edited source bumps the version of its port and of
+// every port downstream of it and marks them stale, Evaluate() only recomputes
+// stale ports (and curves when the time moves), readers compare versions to
+// skip work when nothing upstream changed.
+// steps are grouped by level, a step only reads ports of lower levels, so a
+// large level is split into chunks that run on the WorkQueue threads.
+//=============================================================================
+class GraphPlan : public Object
+{
+    URHO3D_OBJECT(GraphPlan, Object);
+public:
+    static void RegisterObject(Context* context);
+
+    GraphPlan(Context *context);
+    virtual ~GraphPlan();
+
+    GraphModel& GetModel() { return model_; }
+
+    // resolves the port named varName on the node once, the returned slot
+    // stays valid for the lifetime of that port, M_MAX_UNSIGNED if not found
+    unsigned GetSlot(unsigned node, const String &varName) const { return model_.FindPort(node, varName); }
+
+    // bumped whenever anything the slot reads from changes
+    unsigned GetVersion(unsigned slot);
+
+    // per query evaluation
+    float GetValueAtTime(unsigned slot, float time);
+    void SampleRange(unsigned slot, const float *times, float *out, unsigned n);
+    float GetStartTime(unsigned slot);
+    float GetEndTime(unsigned slot);
+    const Variant& GetCurrentValue(unsigned slot);
+
+    // evaluates every port at one time, read the results with GetValue().
+    // the results are published in one copy at the end, call it once per frame
+    void Evaluate(float time);
+    float GetValue(unsigned slot) const { return slot < publishedValues_.Size() ? publishedValues_[slot] : 0.0f; }
+    unsigned GetNumLevels() const       { return levelStart_.Size() ? levelStart_.Size() - 1 : 0; }
+
+    // runs the plan over every instance of the batch, instance times are
+    // time + offset wrapped to loopTime when it's > 0. instances are
+    // independent so large batches are split across the WorkQueue threads
+    void EvaluateInstances(GraphInstanceBatch &batch, float time, float loopTime = 0.0f);
+
+    // block mode, for signal rate connections. runs Evaluate(startTime), then
+    // fills a buffer of GetBlockSize() samples at startTime + i * sampleInterval
+    // for every block connection, the ports upstream of it and downstream of it.
+    // other ports only get the scalar value
+    void EvaluateBlock(float startTime, float sampleInterval);
+    void SetBlockSize(unsigned blockSize);
+    unsigned GetBlockSize() const { return blockSize_; }
+    // NULL if the slot isn't a block port
+    const float* GetBlock(unsigned slot) const;
+
+    const PODVector<PlanStep>& GetSteps() { Compile(); return steps_; }
+
+protected:
+    bool Compile();
+    void Sync();
+    bool ResolvePort(unsigned port);
+    void BuildDependents();
+    void BuildLevels();
+    void BuildBlocks();
+    void EvaluateSteps(unsigned first, unsigned last);
+    static void EvaluateStepsWork(const WorkItem *item, unsigned threadIndex);
+    void EvaluateInstanceRange(GraphInstanceBatch &batch, unsigned first, unsigned last);
+    static void EvaluateInstancesWork(const WorkItem *item, unsigned threadIndex);
+    void PushChanged(unsigned port);
+    const TimeCurve* GetCurveSource(unsigned slot);
+    unsigned GetValueSource(unsigned slot);
+
+protected:
+    GraphModel                model_;
+    unsigned                  compiledVersion_;
+
+    // compiled plan
+    PODVector<PlanStep>       steps_;
+    PODVector<unsigned>       sourcePort_;      // port that produces the value of each port
+    PODVector<unsigned char>  visitState_;
+    PODVector<float>          values_;
+    PODVector<float>          publishedValues_;
+
+    // steps_[levelStart_[l] .. levelStart_[l+1]] make up level l
+    PODVector<unsigned>       levelStart_;
+    PODVector<unsigned>       stepLevel_;
+    float                     evalTime_;
+    bool                      evalTimeChanged_;
+    GraphInstanceBatch       *evalBatch_;
+
+    // block ports, the buffer of a port starts at blockOffset_[port]
+    unsigned                  blockSize_;
+    PODVector<unsigned>       blockOffset_;
+    PODVector<unsigned>       blockStepList_;
+    PODVector<float>          blockValues_;
+    PODVector<float>          blockTime_;
+
+    // ports that copy from each port, dependentList_[dependentStart_[p] .. dependentStart_[p+1]]
+    PODVector<unsigned>       dependentStart_;
+    PODVector<unsigned>       dependentList_;
+    PODVector<unsigned>       portVersion_;
+    PODVector<unsigned char>  stale_;
+    PODVector<unsigned>       pushStack_;
+    float                     lastEvalTime_;
+    bool                      evaluated_;
+};
@@ -33,6 +33,7 @@
 #include <SDL/SDL_log.h>
 
 #include "IOElement.h"
+#include "GraphPlan.h"
 
 #include <Urho3D/DebugNew.h>
 //=============================================================================
@@ -40,14 +41,38 @@
 void IOElement::RegisterObject(Context* context)
 {
     context->RegisterFactory<IOElement>(UI_CATEGORY);
+
+    URHO3D_COPY_BASE_ATTRIBUTES(BorderImage);
+    URHO3D_ACCESSOR_ATTRIBUTE("Variable Name", GetVariableName, SetVariableName, String, String::EMPTY, AM_FILE);
 }
 
 IOElement::IOElement(Context *context) 
     : BorderImage(context)
+    , modelPort_(M_MAX_UNSIGNED)
     , ioType_(IOTYPE_UNDEF) 
 {
 }
 
+IOElement::~IOElement()
+{
+    GraphModel *model = GetModel();
+
+    if ( model )
+        model->RemovePort(modelPort_);
+}
+
+GraphModel* IOElement::GetModel()
+{
+    GraphPlan *graphPlan = GetSubsystem<GraphPlan>();
+
+    return graphPlan ? &graphPlan->GetModel() : NULL;
+}
+
+unsigned IOElement::GetModelNode() const
+{
+    return nodebaseParent_ ? nodebaseParent_->GetModelNode() : M_MAX_UNSIGNED;
+}
+
 bool IOElement::InitBaseNodeParent()
 {
     if ( FindBaseNodePtr() )
@@ -56,6 +81,12 @@ bool IOElement::InitBaseNodeParent()
         if ( GetIOType() == IOTYPE_INPUT )
         {
             GetInputBodyElement()->AddChild(this);
+
+            if ( modelPort_ == M_MAX_UNSIGNED )
+            {
+                modelPort_ = GetModel()->AddPort(GetModelNode(), GetModelPortType(), variableName_);
+                UpdateModelPort();
+            }
         }
         else if ( GetIOType() == IOTYPE_OUTPUT )
         {
@@ -78,6 +109,7 @@ void IOElement::CreateTextLabel()
         SetLayoutBorder(IntRect(5,0,0,0));
 
         labelText_ = CreateChild<Text>();
+        labelText_->SetTemporary(true);
         labelText_->SetAlignment(HA_CENTER, VA_TOP);
         labelText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 8);
         labelText_->SetText("out");
@@ -96,6 +128,12 @@ void IOElement::SetVariableName(const String& varName)
 {
     variableName_ = varName;
     SetTextLabel(varName);
+
+    // connections are resolved by name
+    GraphModel *model = GetModel();
+
+    if ( model )
+        model->SetPortName(modelPort_, varName);
 }
 
 bool IOElement::FindBaseNodePtr()
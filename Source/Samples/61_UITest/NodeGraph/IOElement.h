@@ -23,6 +23,7 @@
 #include <Urho3D/Core/Variant.h>
 
 #include "GraphNode.h"
+#include "GraphModel.h"
 
 //=============================================================================
 //=============================================================================
@@ -43,14 +44,18 @@ public:
     static void RegisterObject(Context* context);
 
     IOElement(Context *context);
-    virtual ~IOElement(){}
+    virtual ~IOElement();
 
     IOType GetIOType() const { return ioType_; }
     GraphNode* GetNodeBasePtr() { return nodebaseParent_; }
 
+    // port in the GraphPlan model, M_MAX_UNSIGNED until an input is placed in a node
+    unsigned GetModelPort() const { return modelPort_; }
+    unsigned GetModelNode() const;
+
     // related to I/O
     void SetVariableName(const String& varName);
-    const String& GetVariableName()         { return variableName_; }
+    const String& GetVariableName() const   { return variableName_; }
 
     // related to timevar input
     virtual float GetValueRangeMin(const String &varName){ return 0.0f; }
@@ -68,6 +73,12 @@ public:
 protected:
     void SetIOType(IOType iotype) { ioType_ = iotype; }
 
+    // inputs are views of a model port, the type of port to create and a
+    // hook to write the element's current state into it once it exists
+    virtual GraphPortType GetModelPortType() const { return PORTTYPE_NONE; }
+    virtual void UpdateModelPort() {}
+    GraphModel* GetModel();
+
     bool InitBaseNodeParent();
     bool SetBasePtrs(UIElement *nodebaseParent);
     bool FindBaseNodePtr();
@@ -86,6 +97,8 @@ protected:
     WeakPtr<Text>      labelText_;
     String             variableName_;
 
+    unsigned           modelPort_;
+
 private:
     IOType ioType_;
 };
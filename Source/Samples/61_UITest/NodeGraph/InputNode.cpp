@@ -44,12 +44,15 @@
 void InputNode::RegisterObject(Context* context)
 {
     context->RegisterFactory<InputNode>(UI_CATEGORY);
+    URHO3D_COPY_BASE_ATTRIBUTES(IOElement);
+    URHO3D_ACCESSOR_ATTRIBUTE("Block Mode", GetBlockMode, SetBlockMode, bool, false, AM_FILE);
     InputBox::RegisterObject(context);
 }
 
 InputNode::InputNode(Context *context)
     : IOElement(context)
     , showInputBox_(true)
+    , blockMode_(false)
 {
     SetIOType(IOTYPE_INPUT);
     SetColor(GraphNode::GetDefaultBodyColor());
@@ -82,6 +85,18 @@ bool InputNode::Create(const String &variableName, const IntVector2 &size)
     return true;
 }
 
+void InputNode::ApplyAttributes()
+{
+    // the label and input box are not part of the snapshot
+    if ( inputBox_ == NULL && !variableName_.Empty() )
+    {
+        Create(variableName_, GetSize());
+    }
+
+    // the port may not have existed when the attribute was set
+    GetModel()->SetBlockMode(modelPort_, blockMode_);
+}
+
 bool InputNode::CreateInputbox()
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -96,6 +111,7 @@ bool InputNode::CreateInputbox()
 
     // inputBox_
     inputBox_ = root->CreateChild<InputBox>();
+    inputBox_->SetTemporary(true);
     inputBox_->SetTexture(tex2d);
     inputBox_->SetImageRect(rect);
     inputBox_->SetPosition(absPos);
@@ -141,6 +157,18 @@ void InputNode::SendReceiverMovedEvent()
     SendEvent(E_RECEIVER_MOVED, eventData);
 }
 
+//=============================================================================
+//=============================================================================
+InputBox::~InputBox()
+{
+    InputNodeManager *inputNodeManager = GetSubsystem<InputNodeManager>();
+
+    if ( inputNodeManager )
+        inputNodeManager->Remove(this);
+}
+
+//=============================================================================
+//=============================================================================
 void InputNode::SetConnectedOutputNode(OutputNode *outputNode)
 {
     connectedOutputNode_ = outputNode;
@@ -150,6 +178,26 @@ void InputNode::SetConnectedOutputNode(OutputNode *outputNode)
     {
         connectedOutputVarName_ = connectedOutputNode_->GetVariableName();
     }
+
+    UpdateModelPort();
+}
+
+void InputNode::UpdateModelPort()
+{
+    GraphModel *model = GetModel();
+
+    if ( connectedOutputNode_ )
+        model->Connect(modelPort_, connectedOutputNode_->GetModelNode(), connectedOutputVarName_);
+    else
+        model->Disconnect(modelPort_);
+
+    model->SetBlockMode(modelPort_, blockMode_);
+}
+
+void InputNode::SetBlockMode(bool block)
+{
+    blockMode_ = block;
+    GetModel()->SetBlockMode(modelPort_, blockMode_);
 }
 
 //=========================================================
@@ -49,6 +49,13 @@ public:
     void SetConnectedOutputNode(OutputNode *outputNode);
     OutputNode* GetConnectedOutputNode() { return connectedOutputNode_; }
 
+    // the connection carries a buffer of samples per evaluation, see GraphPlan::EvaluateBlock()
+    void SetBlockMode(bool block);
+    bool GetBlockMode() const { return blockMode_; }
+
+    // restored from a page snapshot
+    virtual void ApplyAttributes();
+
     // related to timevar input
     virtual float GetValueRangeMin(const String &varName);
     virtual float GetValueRangeMax(const String &varName);
@@ -62,6 +69,9 @@ public:
     virtual const Variant& GetCurrentValue(const String &varName);
 
 protected:
+    virtual GraphPortType GetModelPortType() const { return PORTTYPE_INPUT; }
+    virtual void UpdateModelPort();
+
     bool InitInternal();
 
     bool Init(const IntVector2 &pos, const IntVector2 &size);
@@ -78,6 +88,7 @@ protected:
     WeakPtr<InputBox>   inputBox_;
     IntVector2          controlBoxSize_;
     bool                showInputBox_;
+    bool                blockMode_;
 };
 
 //=============================================================================
@@ -89,15 +100,23 @@ public:
     static void RegisterObject(Context* context)
     {
         context->RegisterFactory<InputBox>(UI_CATEGORY);
+        URHO3D_COPY_BASE_ATTRIBUTES(BorderImage);
     }
 
-    InputBox(Context *context) : BorderImage(context){}
-    virtual ~InputBox(){}
+    InputBox(Context *context) 
+        : BorderImage(context), gridCell_(0), gridSlot_(M_MAX_UNSIGNED) {}
+    virtual ~InputBox();
 
     void SetInputParent(InputNode *parent)  { inputParent_ = parent; }
     InputNode* GetInputParent()             { return inputParent_;   }
 
 protected:
+    friend class InputNodeManager;
+
     WeakPtr<InputNode> inputParent_;
+
+    // InputNodeManager grid cell and the index in it, M_MAX_UNSIGNED when not registered
+    unsigned           gridCell_;
+    unsigned           gridSlot_;
 };
 
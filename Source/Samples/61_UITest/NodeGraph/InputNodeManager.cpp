@@ -46,7 +46,11 @@ void InputNodeManager::RegisterObject(Context* context)
 
 InputNodeManager::InputNodeManager(Context *context)
     : Object(context)
+    , cellSize_(64)
+    , maxBoxSize_(IntVector2::ZERO)
+    , numInputBoxes_(0)
 {
+    SubscribeToEvent(E_RECEIVER_MOVED, URHO3D_HANDLER(InputNodeManager, HandleReceiverMoved));
 }
 
 InputNodeManager::~InputNodeManager()
@@ -55,56 +59,163 @@ InputNodeManager::~InputNodeManager()
 
 bool InputNodeManager::Add(InputBox *inputBox)
 {
-    for ( unsigned i = 0; i < inputBoxList_.Size(); ++i )
+    if ( inputBox == NULL || inputBox->gridSlot_ != M_MAX_UNSIGNED )
     {
-        if ( inputBox == inputBoxList_[i] )
-        {
-            return false;
-        }
+        return false;
     }
 
-    inputBoxList_.Push(inputBox);
+    maxBoxSize_.x_ = Max(maxBoxSize_.x_, inputBox->GetSize().x_);
+    maxBoxSize_.y_ = Max(maxBoxSize_.y_, inputBox->GetSize().y_);
+
+    Insert(inputBox);
+    ++numInputBoxes_;
+
     return true;
 }
 
 bool InputNodeManager::Remove(InputBox *inputBox)
 {
-    bool found = false;
+    if ( inputBox == NULL || inputBox->gridSlot_ == M_MAX_UNSIGNED )
+    {
+        return false;
+    }
+
+    Erase(inputBox);
+    --numInputBoxes_;
+
+    return true;
+}
+
+void InputNodeManager::Move(InputBox *inputBox)
+{
+    if ( inputBox == NULL || inputBox->gridSlot_ == M_MAX_UNSIGNED )
+        return;
+
+    if ( GetCellKey(inputBox->GetPosition()) != inputBox->gridCell_ )
+    {
+        Erase(inputBox);
+        Insert(inputBox);
+    }
+}
+
+void InputNodeManager::SetCellSize(int cellSize)
+{
+    if ( cellSize < 1 || cellSize == cellSize_ )
+        return;
+
+    PODVector<InputBox*> inputBoxes;
+
+    for ( HashMap<unsigned, PODVector<InputBox*> >::Iterator it = gridCells_.Begin(); it != gridCells_.End(); ++it )
+    {
+        inputBoxes.Push(it->second_);
+    }
+
+    gridCells_.Clear();
+    cellSize_ = cellSize;
 
-    for ( unsigned i = 0; i < inputBoxList_.Size(); ++i )
+    for ( unsigned i = 0; i < inputBoxes.Size(); ++i )
     {
-        if ( inputBox == inputBoxList_[i] )
+        Insert(inputBoxes[i]);
+    }
+}
+
+int InputNodeManager::GetCellCoord(int v) const
+{
+    // floor division, positions left of or above the root are negative
+    return v >= 0 ? v / cellSize_ : -((-v + cellSize_ - 1) / cellSize_);
+}
+
+unsigned InputNodeManager::GetCellKey(int cx, int cy) const
+{
+    return ((unsigned)(cx & 0xffff) << 16) | (unsigned)(cy & 0xffff);
+}
+
+unsigned InputNodeManager::GetCellKey(const IntVector2 &pos) const
+{
+    return GetCellKey(GetCellCoord(pos.x_), GetCellCoord(pos.y_));
+}
+
+void InputNodeManager::Insert(InputBox *inputBox)
+{
+    PODVector<InputBox*> &cell = gridCells_[GetCellKey(inputBox->GetPosition())];
+
+    inputBox->gridCell_ = GetCellKey(inputBox->GetPosition());
+    inputBox->gridSlot_ = cell.Size();
+    cell.Push(inputBox);
+}
+
+void InputNodeManager::Erase(InputBox *inputBox)
+{
+    HashMap<unsigned, PODVector<InputBox*> >::Iterator it = gridCells_.Find(inputBox->gridCell_);
+
+    if ( it != gridCells_.End() )
+    {
+        // move the last box of the cell into the freed slot
+        PODVector<InputBox*> &cell = it->second_;
+        unsigned slot = inputBox->gridSlot_;
+
+        cell[slot] = cell.Back();
+        cell[slot]->gridSlot_ = slot;
+        cell.Pop();
+
+        if ( cell.Empty() )
         {
-            inputBoxList_.Erase(i);
-            found = true;
-            break;
+            gridCells_.Erase(it);
         }
     }
-    
-    return found;
+
+    inputBox->gridSlot_ = M_MAX_UNSIGNED;
 }
 
 bool InputNodeManager::GetNodesInside(Vector<InputBox*>& result, const Vector2 &p0, const Vector2 &s0)
 {
     result.Clear();
 
+    // only the cells within reach of the largest box can hold a hit
+    Vector2 maxSize((float)maxBoxSize_.x_, (float)maxBoxSize_.y_);
+    int reach = (int)(((maxSize + s0) * 0.34f).Length()) + 1;
+    int cx0 = GetCellCoord((int)p0.x_ - reach);
+    int cx1 = GetCellCoord((int)p0.x_ + reach);
+    int cy0 = GetCellCoord((int)p0.y_ - reach);
+    int cy1 = GetCellCoord((int)p0.y_ + reach);
+
     // not concerned w/ accuracy: evaluate as circle collision instead of rectangle
     // touching  = (0.5*s1 + 0.5*s0)*0.707 = (s1+s0)*0.3535, base on the length of the sides, for corners change 0.707 to 1.0
     // collision < (s1+s0)*0.3535, use 0.34 for a slight overlap
-    for ( unsigned i = 0; i < inputBoxList_.Size(); ++i )
+    for ( int cy = cy0; cy <= cy1; ++cy )
     {
-        Vector2 p1((float)inputBoxList_[i]->GetPosition().x_, (float)inputBoxList_[i]->GetPosition().y_);
-        Vector2 s1((float)inputBoxList_[i]->GetSize().x_, (float)inputBoxList_[i]->GetSize().y_);
+        for ( int cx = cx0; cx <= cx1; ++cx )
+        {
+            HashMap<unsigned, PODVector<InputBox*> >::ConstIterator it = gridCells_.Find(GetCellKey(cx, cy));
 
-        float plen = (p1 - p0).Length();
-        float slen = ((s1 + s0) * 0.34f).Length();
+            if ( it == gridCells_.End() )
+                continue;
 
-        if ( plen < slen )
-        {
-            result.Push(inputBoxList_[i]);
+            const PODVector<InputBox*> &cell = it->second_;
+
+            for ( unsigned i = 0; i < cell.Size(); ++i )
+            {
+                Vector2 p1((float)cell[i]->GetPosition().x_, (float)cell[i]->GetPosition().y_);
+                Vector2 s1((float)cell[i]->GetSize().x_, (float)cell[i]->GetSize().y_);
+
+                float plen = (p1 - p0).Length();
+                float slen = ((s1 + s0) * 0.34f).Length();
+
+                if ( plen < slen )
+                {
+                    result.Push(cell[i]);
+                }
+            }
         }
     }
 
     return (result.Size() > 0);
 }
 
+void InputNodeManager::HandleReceiverMoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ReceiverMoved;
+
+    Move((InputBox*)eventData[P_ELEMENT].GetVoidPtr());
+}
+
@@ -37,8 +37,28 @@ public:
     bool Remove(InputBox *inputBox);
     bool GetNodesInside(Vector<InputBox*> &result, const Vector2 &pos, const Vector2 &size);
 
+    // re-files the box after it moved, called on E_RECEIVER_MOVED
+    void Move(InputBox *inputBox);
+
+    // the grid cell should be larger than the input boxes, existing boxes are re-filed
+    void SetCellSize(int cellSize);
+    int GetCellSize() const { return cellSize_; }
+    unsigned GetNumInputBoxes() const { return numInputBoxes_; }
+
+protected:
+    unsigned GetCellKey(int cx, int cy) const;
+    unsigned GetCellKey(const IntVector2 &pos) const;
+    int GetCellCoord(int v) const;
+    void Insert(InputBox *inputBox);
+    void Erase(InputBox *inputBox);
+    void HandleReceiverMoved(StringHash eventType, VariantMap& eventData);
+
 protected:
-	Vector<InputBox*> inputBoxList_;
+    // uniform grid keyed by the cell of the InputBox position
+    HashMap<unsigned, PODVector<InputBox*> > gridCells_;
+    int               cellSize_;
+    IntVector2        maxBoxSize_;
+    unsigned          numInputBoxes_;
 };
 
 
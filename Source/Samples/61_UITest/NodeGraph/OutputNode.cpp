@@ -48,18 +48,27 @@
 const Color LINEColor(0.0f, 0.8f, 0.8f);
 const Color CONNECTEDColor(0.3f, 0.8f, 0.3f);
 const Color DISCONNECTEDColor(0.8f, 0.3f, 0.3f);
+const Color HOVERColor(0.3f, 1.0f, 0.3f);
 
 //=============================================================================
 //=============================================================================
 void OutputNode::RegisterObject(Context* context)
 {
     context->RegisterFactory<OutputNode>(UI_CATEGORY);
+
+    URHO3D_COPY_BASE_ATTRIBUTES(IOElement);
+    URHO3D_ACCESSOR_ATTRIBUTE("Show Output Line", IsOutputLineShown, ShowOutputLine, bool, true, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Ctrl Button Enabled", IsCtrlButtonEnabled, SetEnableCtrlButton, bool, true, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Connected Input", GetConnectedInputAttr, SetConnectedInputAttr, int, -1, AM_FILE);
+
     OutputBox::RegisterObject(context);
 }
 
 OutputNode::OutputNode(Context *context)
     : IOElement(context)
     , showOutputLine_(true)
+    , ctrlButtonEnabled_(true)
+    , connectedInputId_(-1)
 {
     SetIOType(IOTYPE_OUTPUT);
     SetColor(GraphNode::GetDefaultBodyColor());
@@ -95,6 +104,50 @@ bool OutputNode::Create(const String &variableName, const IntVector2 &size)
     return true;
 }
 
+void OutputNode::SetEnableCtrlButton(bool enable)
+{
+    ctrlButtonEnabled_ = enable;
+
+    if ( ctrlButton_ )
+    {
+        ctrlButton_->SetEnabled(enable);
+    }
+}
+
+int OutputNode::GetConnectedInputAttr() const
+{
+    return GetSubsystem<PageManager>()->GetSnapshotId(connectedInputNode_);
+}
+
+void OutputNode::ApplyAttributes()
+{
+    // the boxes and the line are not part of the snapshot
+    if ( outputBox_ == NULL && !variableName_.Empty() )
+    {
+        Create(variableName_, GetSize());
+        SetEnableCtrlButton(ctrlButtonEnabled_);
+    }
+
+    // the input node may not have its input box yet, connect once all are restored
+    if ( connectedInputId_ >= 0 )
+    {
+        SubscribeToEvent(GetSubsystem<PageManager>(), E_PAGERESTORED, URHO3D_HANDLER(OutputNode, HandlePageRestored));
+    }
+}
+
+void OutputNode::HandlePageRestored(StringHash eventType, VariantMap& eventData)
+{
+    UIElement *element = GetSubsystem<PageManager>()->GetSnapshotElement(connectedInputId_);
+
+    if ( element && element->GetType() == InputNode::GetTypeStatic() )
+    {
+        AttemptConnect((InputNode*)element);
+    }
+
+    connectedInputId_ = -1;
+    UnsubscribeFromEvent(GetSubsystem<PageManager>(), E_PAGERESTORED);
+}
+
 bool OutputNode::CreateLineBatcher(LineType linetype, const Color& color, float pixelSize)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -110,6 +163,7 @@ bool OutputNode::CreateLineBatcher(LineType linetype, const Color& color, float
 
     // outputBox_
     outputBox_ = root->CreateChild<OutputBox>();
+    outputBox_->SetTemporary(true);
     outputBox_->SetTexture(tex2d);
     outputBox_->SetImageRect(rect);
     outputBox_->SetPosition(absPos);
@@ -119,6 +173,7 @@ bool OutputNode::CreateLineBatcher(LineType linetype, const Color& color, float
 
     // ctrlButton_ 
     ctrlButton_ = root->CreateChild<Button>();
+    ctrlButton_->SetTemporary(true);
     ctrlButton_->SetTexture(tex2d);
     ctrlButton_->SetImageRect(rect);
     ctrlButton_->SetSize(controlBoxSize_);
@@ -134,6 +189,7 @@ bool OutputNode::CreateLineBatcher(LineType linetype, const Color& color, float
     pixelSize_ = pixelSize;
 
     lineBatcher_ = root->CreateChild<LineBatcher>();
+    lineBatcher_->SetTemporary(true);
     lineBatcher_->SetLineTexture(tex2d);
     lineBatcher_->SetLineRect(rect);
     lineBatcher_->SetLineType(linetype);
@@ -206,6 +262,8 @@ void OutputNode::HandleButtonDragMove(StringHash eventType, VariantMap& eventDat
 
     ctrlButton_->SetPosition(scrnPos);
 
+    SetHoverInputBox(FindDropTarget());
+
     if ( showOutputLine_ )
     {
         CreateLinePoints( firstPos, btnPos );
@@ -223,6 +281,8 @@ void OutputNode::HandleButtonDragEnd(StringHash eventType, VariantMap& eventData
     Vector2 s0((float)ctrlButton_->GetSize().x_, (float)ctrlButton_->GetSize().y_);
     Vector<InputBox*> result;
 
+    SetHoverInputBox(NULL);
+
     if ( GetSubsystem<InputNodeManager>()->GetNodesInside(result, p0, s0) )
     {
         for ( unsigned i = 0; i < result.Size(); ++i )
@@ -237,6 +297,44 @@ void OutputNode::HandleButtonDragEnd(StringHash eventType, VariantMap& eventData
     }
 }
 
+InputBox* OutputNode::FindDropTarget()
+{
+    Vector2 p0((float)ctrlButton_->GetPosition().x_, (float)ctrlButton_->GetPosition().y_);
+    Vector2 s0((float)ctrlButton_->GetSize().x_, (float)ctrlButton_->GetSize().y_);
+    Vector<InputBox*> result;
+
+    if ( GetSubsystem<InputNodeManager>()->GetNodesInside(result, p0, s0) )
+    {
+        for ( unsigned i = 0; i < result.Size(); ++i )
+        {
+            InputNode *inputNode = result[i]->GetInputParent();
+
+            // same rules as AttemptConnect()
+            if ( inputNode && !inputNode->GetConnectedOutputNode() && inputNode->GetNodeBasePtr() != GetNodeBasePtr() )
+                return result[i];
+        }
+    }
+
+    return NULL;
+}
+
+void OutputNode::SetHoverInputBox(InputBox *inputBox)
+{
+    if ( inputBox == hoverInputBox_ )
+        return;
+
+    if ( hoverInputBox_ )
+        hoverInputBox_->SetColor(hoverRestoreColor_);
+
+    hoverInputBox_ = inputBox;
+
+    if ( hoverInputBox_ )
+    {
+        hoverRestoreColor_ = hoverInputBox_->GetColor(C_TOPLEFT);
+        hoverInputBox_->SetColor(HOVERColor);
+    }
+}
+
 bool OutputNode::AttemptConnect(InputNode *inputNode)
 {
     if ( inputNode )
@@ -27,7 +27,7 @@ class OutputBox;
 //=============================================================================
 class OutputNode : public IOElement
 {
-    URHO3D_OBJECT(IOElement, GraphNode);
+    URHO3D_OBJECT(OutputNode, IOElement);
 public:
     static void RegisterObject(Context* context);
 
@@ -36,9 +36,16 @@ public:
 
     virtual bool Create(const String &variableName, const IntVector2 &size);
     void ShowOutputLine(bool show) { showOutputLine_ = show; }
+    bool IsOutputLineShown() const { return showOutputLine_; }
 
     bool ConnectToInput(InputNode *inputNode);
-    void SetEnableCtrlButton(bool enable) { ctrlButton_->SetEnabled(enable); }
+    void SetEnableCtrlButton(bool enable);
+    bool IsCtrlButtonEnabled() const { return ctrlButtonEnabled_; }
+
+    // restored from a page snapshot
+    virtual void ApplyAttributes();
+    int GetConnectedInputAttr() const;
+    void SetConnectedInputAttr(int id) { connectedInputId_ = id; }
 
     // related to timevar input
     virtual float GetValueRangeMin(const String &varName);
@@ -64,16 +71,23 @@ protected:
     void HandleButtonDragEnd(StringHash eventType, VariantMap& eventData);
     void HandleReceiverMoved(StringHash eventType, VariantMap& eventData);
     void HandleLayoutUpdated(StringHash eventType, VariantMap& eventData);
+    void HandlePageRestored(StringHash eventType, VariantMap& eventData);
     bool AttemptConnect(InputNode *inputNode);
     void CreateLinePoints(const IntVector2 &pos0, const IntVector2 &pos4);
     void SnapToInputNode();
     void CalculateInnerPoints();
+    InputBox* FindDropTarget();
+    void SetHoverInputBox(InputBox *inputBox);
 
 protected:
     WeakPtr<OutputBox>    outputBox_;
     WeakPtr<Button>       ctrlButton_;
     WeakPtr<InputNode>    connectedInputNode_;
 
+    // input under the ctrl button while dragging a connection
+    WeakPtr<InputBox>     hoverInputBox_;
+    Color                 hoverRestoreColor_;
+
     WeakPtr<LineBatcher>  lineBatcher_;
     PODVector<IntVector2> absolutePositionList_;
 
@@ -81,6 +95,8 @@ protected:
     LineType              linetype_;
     float                 pixelSize_;
     bool                  showOutputLine_;
+    bool                  ctrlButtonEnabled_;
+    int                   connectedInputId_;
 
 protected:
     enum PointSizeType{ MAX_POINTS = 5 };
@@ -95,6 +111,7 @@ public:
     static void RegisterObject(Context* context)
     {
         context->RegisterFactory<OutputBox>(UI_CATEGORY);
+        URHO3D_COPY_BASE_ATTRIBUTES(BorderImage);
     }
 
     OutputBox(Context *context) : BorderImage(context){}
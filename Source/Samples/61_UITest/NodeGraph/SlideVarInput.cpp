@@ -47,6 +47,10 @@
 void SlideVarInput::RegisterObject(Context* context)
 {
     context->RegisterFactory<SlideVarInput>();
+
+    URHO3D_COPY_BASE_ATTRIBUTES(IOElement);
+    URHO3D_ACCESSOR_ATTRIBUTE("Sensitivity", GetSensitivity, SetSensitivity, float, 0.1f, AM_FILE);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Values", GetValuesAttr, SetValuesAttr, VariantVector, Variant::emptyVariantVector, AM_FILE);
 }
 
 SlideVarInput::SlideVarInput(Context *context)
@@ -81,6 +85,7 @@ bool SlideVarInput::CreateBar(const String &variableName, const IntVector2 &size
         SetLayoutBorder(IntRect(5,0,0,0));
 
         variableText_ = CreateChild<Text>();
+        variableText_->SetTemporary(true);
         variableText_->SetVerticalAlignment(VA_CENTER);
         variableText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 10);
     }
@@ -125,6 +130,47 @@ void SlideVarInput::SetCurrentValue(const Variant &val)
     default:
         assert(false && "only INT and FLOAT are implemented, implement what you need");
     }
+
+    UpdateModelPort();
+}
+
+void SlideVarInput::UpdateModelPort()
+{
+    GetModel()->SetValue(modelPort_, varCurrentValue_);
+}
+
+void SlideVarInput::ApplyAttributes()
+{
+    if ( variableText_ == NULL && !variableName_.Empty() )
+    {
+        CreateBar(variableName_, GetSize());
+
+        if ( varCurrentValue_.GetType() != VAR_NONE )
+        {
+            SetCurrentValue(varCurrentValue_);
+        }
+    }
+}
+
+VariantVector SlideVarInput::GetValuesAttr() const
+{
+    VariantVector values;
+    values.Push(varMin_);
+    values.Push(varMax_);
+    values.Push(varCurrentValue_);
+
+    return values;
+}
+
+void SlideVarInput::SetValuesAttr(const VariantVector &values)
+{
+    // the value text is created in ApplyAttributes()
+    if ( values.Size() == 3 )
+    {
+        varMin_          = values[0];
+        varMax_          = values[1];
+        varCurrentValue_ = values[2];
+    }
 }
 
 void SlideVarInput::SetVarChangedCallback(UIElement *process, VarChangedCallback callback)
@@ -135,6 +181,8 @@ void SlideVarInput::SetVarChangedCallback(UIElement *process, VarChangedCallback
 
 void SlideVarInput::ValueUpdate(float delta)
 {
+    Variant prevValue = varCurrentValue_;
+
     if (varMax_.GetType() == VAR_INT)
     {
         currentValue_ += delta * sensitivity_;
@@ -150,6 +198,12 @@ void SlideVarInput::ValueUpdate(float delta)
         variableText_->SetText( String(varCurrentValue_.GetFloat()) );
     }
 
+    // an int slider only changes once the drag crosses a whole step
+    if ( varCurrentValue_ != prevValue )
+    {
+        UpdateModelPort();
+    }
+
     // listener callback
     if (processCaller && pfnVarChangedCallback)
     {
@@ -58,16 +58,25 @@ public:
     void SetRange(const Variant &vmin, const Variant &vmax);
     void SetCurrentValue(const Variant &val);
     void SetSensitivity(float sensitivity) { sensitivity_ = sensitivity; }
+    float GetSensitivity() const { return sensitivity_; }
     void SetVarChangedCallback(UIElement *process, VarChangedCallback callback);
 
     const Variant& GetCurrentValue() { return varCurrentValue_; }
 
+    // restored from a page snapshot, the callback is reattached by its owner
+    virtual void ApplyAttributes();
+    VariantVector GetValuesAttr() const;
+    void SetValuesAttr(const VariantVector &values);
+
     // related to slidevar input
     virtual const Variant& GetRangeMin(const String &varName);
     virtual const Variant& GetRangeMax(const String &varName);
     virtual const Variant& GetCurrentValue(const String &varName);
 
 protected:
+    virtual GraphPortType GetModelPortType() const { return PORTTYPE_VALUE; }
+    virtual void UpdateModelPort();
+
     bool InitInternal();
     void ValueUpdate(float val);
 
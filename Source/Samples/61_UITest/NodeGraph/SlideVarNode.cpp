@@ -33,6 +33,7 @@
 void SlideVarNode::RegisterObject(Context* context)
 {
     context->RegisterFactory<SlideVarNode>();
+    URHO3D_COPY_BASE_ATTRIBUTES(GraphNode);
 }
 
 SlideVarNode::SlideVarNode(Context *context)
@@ -46,6 +47,20 @@ SlideVarNode::~SlideVarNode()
 {
 }
 
+void SlideVarNode::ApplyAttributes()
+{
+    // the io elements created in the constructor were replaced by the restored ones
+    if ( slideVarInput_ == NULL )
+    {
+        slideVarInput_ = (SlideVarInput*)FindIOElement(SlideVarInput::GetTypeStatic());
+    }
+
+    if ( outputNode_ == NULL )
+    {
+        outputNode_ = (OutputNode*)FindIOElement(OutputNode::GetTypeStatic());
+    }
+}
+
 bool SlideVarNode::CreateBar(const String &variableName, const IntVector2 &size, bool showOutput)
 {
     slideVarInput_->CreateBar(variableName, size);
@@ -49,6 +49,9 @@ public:
 
     const Variant& GetCurrentValue() { return slideVarInput_->GetCurrentValue(); }
 
+    // restored from a page snapshot
+    virtual void ApplyAttributes();
+
 protected:
     WeakPtr<SlideVarInput> slideVarInput_;
     WeakPtr<OutputNode>    outputNode_;
@@ -0,0 +1,265 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include <Urho3D/Math/MathDefs.h>
+
+#include "TimeCurve.h"
+
+#include <Urho3D/DebugNew.h>
+//=============================================================================
+//=============================================================================
+#define SAMPLE_BLOCK_SIZE   64
+
+//=============================================================================
+//=============================================================================
+TimeCurve::TimeCurve()
+    : resolution_(DEFAULT_CURVE_LUT_SIZE)
+    , lutScale_(0.0f)
+    , timeStart_(0.0f)
+    , timeEnd_(1.0f)
+{
+}
+
+void TimeCurve::SetKeys(const PODVector<float> &times, const PODVector<float> &values)
+{
+    assert(times.Size() == values.Size() && "key times and values must match");
+
+    keyTimes_ = times;
+    keyValues_ = values;
+
+    unsigned numKeys = keyTimes_.Size();
+    unsigned numSpans = numKeys > 1 ? numKeys - 1 : 0;
+
+    coefA_.Resize(numSpans);
+    coefB_.Resize(numSpans);
+    coefC_.Resize(numSpans);
+    coefD_.Resize(numSpans);
+    invSpanLength_.Resize(numSpans);
+
+    for ( unsigned i = 0; i < numSpans; ++i )
+    {
+        float length = keyTimes_[i + 1] - keyTimes_[i];
+        float p1 = keyValues_[i];
+        float p2 = keyValues_[i + 1];
+
+        // hermite form, tangents scaled to the span
+        float m1 = GetKeyTangent(i) * length;
+        float m2 = GetKeyTangent(i + 1) * length;
+
+        coefA_[i] = 2.0f * p1 - 2.0f * p2 + m1 + m2;
+        coefB_[i] = -3.0f * p1 + 3.0f * p2 - 2.0f * m1 - m2;
+        coefC_[i] = m1;
+        coefD_[i] = p1;
+        invSpanLength_[i] = length > 0.0f ? 1.0f / length : 0.0f;
+    }
+
+    Bake();
+}
+
+float TimeCurve::GetKeyTangent(unsigned idx) const
+{
+    // the end keys are doubled like the spline does, the doubled key sits one
+    // span out so evenly spaced keys give the same curve as the spline
+    unsigned last = keyTimes_.Size() - 1;
+    float prevTime, prevValue, nextTime, nextValue;
+
+    if ( idx > 0 )
+    {
+        prevTime = keyTimes_[idx - 1];
+        prevValue = keyValues_[idx - 1];
+    }
+    else
+    {
+        prevTime = 2.0f * keyTimes_[0] - keyTimes_[1];
+        prevValue = keyValues_[0];
+    }
+
+    if ( idx < last )
+    {
+        nextTime = keyTimes_[idx + 1];
+        nextValue = keyValues_[idx + 1];
+    }
+    else
+    {
+        nextTime = 2.0f * keyTimes_[last] - keyTimes_[last - 1];
+        nextValue = keyValues_[last];
+    }
+
+    float dt = nextTime - prevTime;
+
+    return dt > 0.0f ? (nextValue - prevValue) / dt : 0.0f;
+}
+
+void TimeCurve::SetResolution(unsigned resolution)
+{
+    if ( resolution != resolution_ )
+    {
+        resolution_ = resolution;
+        Bake();
+    }
+}
+
+void TimeCurve::Bake()
+{
+    unsigned numKeys = keyTimes_.Size();
+
+    if ( resolution_ == 0 || numKeys < 2 || keyTimes_.Back() <= keyTimes_[0] )
+    {
+        lut_.Clear();
+        return;
+    }
+
+    float keyStart = keyTimes_[0];
+    float keyLength = keyTimes_.Back() - keyStart;
+
+    lut_.Resize(resolution_ + 1);
+    lutScale_ = (float)resolution_ / keyLength;
+
+    // the entry times are ascending, so the span lookup just walks forward
+    unsigned span = 0;
+
+    for ( unsigned i = 0; i <= resolution_; ++i )
+    {
+        float time = keyStart + keyLength * (float)i / (float)resolution_;
+
+        while ( span + 2 < numKeys && time >= keyTimes_[span + 1] )
+            ++span;
+
+        float t = Clamp((time - keyTimes_[span]) * invSpanLength_[span], 0.0f, 1.0f);
+        lut_[i] = ((coefA_[span] * t + coefB_[span]) * t + coefC_[span]) * t + coefD_[span];
+    }
+}
+
+void TimeCurve::SetTimeRange(float timeStart, float timeEnd)
+{
+    timeStart_ = timeStart;
+    timeEnd_ = timeEnd;
+}
+
+float TimeCurve::Sample(float time) const
+{
+    float out;
+    SampleRange(&time, &out, 1);
+    return out;
+}
+
+void TimeCurve::SampleRange(const float *times, float *out, unsigned n) const
+{
+    if ( keyTimes_.Size() < 2 )
+    {
+        float value = keyValues_.Size() ? keyValues_.Back() : 0.0f;
+
+        for ( unsigned i = 0; i < n; ++i )
+            out[i] = value;
+        return;
+    }
+
+    if ( lut_.Empty() )
+    {
+        EvaluateRange(times, out, n);
+        return;
+    }
+
+    const float *lut = &lut_[0];
+    const float keyStart = keyTimes_[0];
+    const float maxPos = (float)resolution_;
+    const int lastEntry = (int)resolution_ - 1;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        float x = (Clamp(times[i], timeStart_, timeEnd_) - keyStart) * lutScale_;
+        x = x > 0.0f ? x : 0.0f;
+        x = x < maxPos ? x : maxPos;
+        int e = (int)x;
+        e = e > lastEntry ? lastEntry : e;
+        float f = x - (float)e;
+        out[i] = lut[e] + (lut[e + 1] - lut[e]) * f;
+    }
+}
+
+unsigned TimeCurve::FindSpan(float time, unsigned hint) const
+{
+    const unsigned lastSpan = keyTimes_.Size() - 2;
+
+    // consecutive samples usually land in the same or the next span
+    if ( time >= keyTimes_[hint] )
+    {
+        if ( hint == lastSpan || time < keyTimes_[hint + 1] )
+            return hint;
+
+        if ( hint + 1 == lastSpan || time < keyTimes_[hint + 2] )
+            return hint + 1;
+    }
+
+    // last span whose start key is <= time
+    unsigned lo = 0;
+    unsigned hi = lastSpan;
+
+    while ( lo < hi )
+    {
+        unsigned mid = (lo + hi + 1) >> 1;
+
+        if ( keyTimes_[mid] <= time )
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    return lo;
+}
+
+void TimeCurve::EvaluateRange(const float *times, float *out, unsigned n) const
+{
+    const float *coefA = &coefA_[0];
+    const float *coefB = &coefB_[0];
+    const float *coefC = &coefC_[0];
+    const float *coefD = &coefD_[0];
+    const float *keyTimes = &keyTimes_[0];
+    const float *invSpanLength = &invSpanLength_[0];
+    const float keyStart = keyTimes_[0];
+    const float keyEnd = keyTimes_.Back();
+
+    unsigned span[SAMPLE_BLOCK_SIZE];
+    float    frac[SAMPLE_BLOCK_SIZE];
+    unsigned hint = 0;
+
+    for ( unsigned base = 0; base < n; base += SAMPLE_BLOCK_SIZE )
+    {
+        unsigned count = Min(n - base, (unsigned)SAMPLE_BLOCK_SIZE);
+
+        // span lookup
+        for ( unsigned i = 0; i < count; ++i )
+        {
+            float t = Clamp(Clamp(times[base + i], timeStart_, timeEnd_), keyStart, keyEnd);
+            hint = FindSpan(t, hint);
+            span[i] = hint;
+            frac[i] = t;
+        }
+
+        // evaluate, no branches
+        for ( unsigned i = 0; i < count; ++i )
+        {
+            unsigned s = span[i];
+            float t = (frac[i] - keyTimes[s]) * invSpanLength[s];
+            out[base + i] = ((coefA[s] * t + coefB[s]) * t + coefC[s]) * t + coefD[s];
+        }
+    }
+}
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+#include <Urho3D/Container/Vector.h>
+
+using namespace Urho3D;
+//=============================================================================
+// value curve of a TimeVarInput, a catmull-rom curve through keys at arbitrary
+// sorted times, end keys doubled like a CATMULL_ROM_FULL_CURVE Spline. keys are
+// kept as per span polynomial coefficients in value space so sampling needs no
+// allocation or conversion, the span of a time is found by a binary search
+// started from the previous sample's span.
+// the curve is also baked into a lookup table that's sampled with a lerp,
+// resolution 0 turns the table off and evaluates the polynomials directly
+//=============================================================================
+#define DEFAULT_CURVE_LUT_SIZE  256
+
+class TimeCurve
+{
+public:
+    TimeCurve();
+
+    // times must be ascending
+    void SetKeys(const PODVector<float> &times, const PODVector<float> &values);
+    void SetTimeRange(float timeStart, float timeEnd);
+    void SetResolution(unsigned resolution);
+
+    unsigned GetNumKeys() const           { return keyTimes_.Size(); }
+    float GetKeyTime(unsigned idx) const  { return keyTimes_[idx]; }
+    float GetKeyValue(unsigned idx) const { return keyValues_[idx]; }
+    unsigned GetResolution() const        { return resolution_; }
+    float GetTimeStart() const            { return timeStart_; }
+    float GetTimeEnd() const              { return timeEnd_; }
+
+    float Sample(float time) const;
+
+    // samples n times into out, times and out may not overlap
+    void SampleRange(const float *times, float *out, unsigned n) const;
+
+protected:
+    void Bake();
+    void EvaluateRange(const float *times, float *out, unsigned n) const;
+    unsigned FindSpan(float time, unsigned hint) const;
+    float GetKeyTangent(unsigned idx) const;
+
+protected:
+    PODVector<float> keyTimes_;
+    PODVector<float> keyValues_;
+
+    // span coefficients over the span's local 0..1 parameter,
+    // value = ((a*t + b)*t + c)*t + d
+    PODVector<float> coefA_;
+    PODVector<float> coefB_;
+    PODVector<float> coefC_;
+    PODVector<float> coefD_;
+    PODVector<float> invSpanLength_;
+
+    // resolution_ + 1 entries evenly spaced between the first and last key
+    PODVector<float> lut_;
+    unsigned         resolution_;
+    float            lutScale_;
+
+    float            timeStart_;
+    float            timeEnd_;
+};
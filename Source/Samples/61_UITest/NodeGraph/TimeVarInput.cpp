@@ -43,11 +43,17 @@
 #define CTRL_BUTTON_SIZE     10
 #define BUTTON_SPACING       CTRL_BUTTON_SIZE*2
 #define DEFAULT_LINE_SIZE    2.0f
+#define DEFAULT_NUM_POINTS   5
 //=============================================================================
 //=============================================================================
 void TimeVarInput::RegisterObject(Context* context)
 {
     context->RegisterFactory<TimeVarInput>(UI_CATEGORY);
+
+    URHO3D_COPY_BASE_ATTRIBUTES(IOElement);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Value Range", GetValueRangeAttr, SetValueRangeAttr, Vector2, Vector2(0.0f, 1.0f), AM_FILE);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Time Range", GetTimeRangeAttr, SetTimeRangeAttr, Vector2, Vector2(0.0f, 1.0f), AM_FILE);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Curve Points", GetCurvePointsAttr, SetCurvePointsAttr, VariantVector, Variant::emptyVariantVector, AM_FILE);
 }
 
 TimeVarInput::TimeVarInput(Context *context) 
@@ -60,7 +66,6 @@ TimeVarInput::TimeVarInput(Context *context)
     , timeRange_(1.0f)
 {
     SetIOType(IOTYPE_INPUT);
-    spline_.SetInterpolationMode(CATMULL_ROM_FULL_CURVE);
 }
 
 TimeVarInput::~TimeVarInput()
@@ -90,6 +95,68 @@ bool TimeVarInput::Create(const String &variableName, const IntVector2 &size)
     return true;
 }
 
+void TimeVarInput::ApplyAttributes()
+{
+    // the texts, buttons and line are not part of the snapshot
+    if ( lineBatcher_ != NULL || variableName_.Empty() )
+        return;
+
+    Vector2 valueRange(minValue_, maxValue_);
+    Vector2 timeRange(timeStart_, timeEnd_);
+
+    if ( !Create(variableName_, GetSize()) )
+        return;
+
+    SetValueRange(valueRange.x_, valueRange.y_);
+    SetTimeRange(timeRange.x_, timeRange.y_);
+
+    if ( restoredKeyList_.Size() > 1 )
+    {
+        SetCurveKeys(restoredKeyList_);
+    }
+
+    restoredKeyList_.Clear();
+}
+
+void TimeVarInput::SetValueRangeAttr(const Vector2 &range)
+{
+    // the range texts are created in ApplyAttributes()
+    minValue_ = range.x_;
+    maxValue_ = range.y_;
+    valueRange_ = maxValue_ - minValue_;
+    UpdateKeysFromButtons();
+}
+
+void TimeVarInput::SetTimeRangeAttr(const Vector2 &range)
+{
+    timeStart_ = range.x_;
+    timeEnd_ = range.y_;
+    timeRange_ = timeEnd_ - timeStart_;
+    UpdateKeysFromButtons();
+}
+
+VariantVector TimeVarInput::GetCurvePointsAttr() const
+{
+    VariantVector points;
+
+    for ( unsigned i = 0; i < keyTimes_.Size(); ++i )
+    {
+        points.Push(Vector2(keyTimes_[i], keyValues_[i]));
+    }
+
+    return points;
+}
+
+void TimeVarInput::SetCurvePointsAttr(const VariantVector &points)
+{
+    restoredKeyList_.Resize(points.Size());
+
+    for ( unsigned i = 0; i < points.Size(); ++i )
+    {
+        restoredKeyList_[i] = points[i].GetVector2();
+    }
+}
+
 bool TimeVarInput::InitScreen(const IntVector2 &size)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -103,7 +170,7 @@ bool TimeVarInput::InitScreen(const IntVector2 &size)
     int horizSpacing = scrnSize.x_/4;
     controlBoxSize_ = IntVector2(CTRL_BUTTON_SIZE, CTRL_BUTTON_SIZE);
 
-    IntVector2 points[MAX_POINTS] =
+    IntVector2 points[DEFAULT_NUM_POINTS] =
     {
         { controlBoxSize_.x_/2, scrnSize.y_/2 },
         { horizSpacing * 1, scrnSize.y_/2 },
@@ -112,16 +179,13 @@ bool TimeVarInput::InitScreen(const IntVector2 &size)
         { horizSpacing * 4 - controlBoxSize_.x_/2, scrnSize.y_/2 },
     };
 
-    pointList_.Resize(MAX_POINTS);
-    absolutePositionList_.Resize(MAX_POINTS);
-    spline_.Clear();
+    pointList_.Resize(DEFAULT_NUM_POINTS);
+    absolutePositionList_.Resize(DEFAULT_NUM_POINTS);
 
-    for ( int i = 0; i < MAX_POINTS; ++i )
+    for ( int i = 0; i < DEFAULT_NUM_POINTS; ++i )
     {
         pointList_[i] = points[i];
         absolutePositionList_[i] = points[i] + absPos;
-        Variant var = Vector2((float)pointList_[i].x_, (float)pointList_[i].y_);
-        spline_.AddKnot(var);
     }
 
     // text
@@ -143,6 +207,7 @@ Text* TimeVarInput::CreateText(int size, const IntVector2 &pos)
     ResourceCache* cache = GetSubsystem<ResourceCache>();
 
     Text* text = CreateChild<Text>();
+    text->SetTemporary(true);
     text->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), size);
     text->SetPosition(pos);
     return text;
@@ -159,6 +224,7 @@ bool TimeVarInput::CreateLineBatcher(LineType linetype, const Color& color, floa
     pixelSize_ = pixelSize;
 
     lineBatcher_ = CreateChild<LineBatcher>();
+    lineBatcher_->SetTemporary(true);
     lineBatcher_->SetLineTexture(uiTex2d);
     lineBatcher_->SetLineRect(rect);
     lineBatcher_->SetLineType(linetype);
@@ -181,84 +247,104 @@ bool TimeVarInput::CreateButtons()
         return false;
     }
 
+    for ( unsigned i = 0; i < pointList_.Size(); ++i )
+    {
+        Button *button = CreateButton();
+        button->SetPosition(pointList_[i] - controlBoxSize_/2);
+
+        buttonList_.Push(button);
+    }
+
+    UpdateKeysFromButtons();
+
+    return true;
+}
+
+Button* TimeVarInput::CreateButton()
+{
     ResourceCache *cache = GetSubsystem<ResourceCache>();
     Texture2D *uiTex2d = cache->GetResource<Texture2D>("Textures/UI.png");
-    PageManager* ui = GetSubsystem<PageManager>();
-    UIElement* root = ui->GetRoot();
     IntRect rect = LineBatcher::GetBoxRect();
-    IntVector2 boxsize = LineBatcher::GetBoxSize();
 
-    for ( int i = 0; i < (int)pointList_.Size(); ++i )
-    {
-        Button *button = CreateChild<Button>();
-        button->SetTexture(uiTex2d);
-        button->SetImageRect(rect);
-        button->SetPosition(pointList_[i] - controlBoxSize_/2);
-        button->SetSize(controlBoxSize_);
-        button->SetVisible(true);
-        button->SetColor(Color(1,1,0));
+    Button *button = CreateChild<Button>();
+    button->SetTemporary(true);
+    button->SetTexture(uiTex2d);
+    button->SetImageRect(rect);
+    button->SetSize(controlBoxSize_);
+    button->SetVisible(true);
+    button->SetColor(Color(1,1,0));
 
-        buttonList_.Push(button);
+    SubscribeToEvent(button, E_DRAGMOVE, URHO3D_HANDLER(TimeVarInput, HandleButtonDragMove));
 
-        SubscribeToEvent(button, E_DRAGMOVE, URHO3D_HANDLER(TimeVarInput, HandleButtonDragMove));
+    return button;
+}
+
+void TimeVarInput::SetNumButtons(unsigned num)
+{
+    while ( buttonList_.Size() < num )
+    {
+        buttonList_.Push(CreateButton());
     }
 
-    return true;
+    while ( buttonList_.Size() > num )
+    {
+        buttonList_.Back()->Remove();
+        buttonList_.Pop();
+    }
+
+    pointList_.Resize(num);
+    absolutePositionList_.Resize(num);
 }
 
 bool TimeVarInput::InitDataCurvePoints(const PODVector<Vector2> &points)
 {
-    if ( points.Size() != MAX_POINTS )
+    if ( points.Size() < 2 )
     {
         return false;
     }
 
-    // eval curve points and normalize (scaled to range)
-    IntVector2 scrnSize = GetSize() - controlBoxSize_;
-    PODVector<IntVector2> scrnPoints;
+    // fit the ranges to the points
+    EvaluateCurvePoints(points);
 
-    EvaluateCurvePoints(points, scrnPoints);
+    return SetCurveKeys(points);
+}
 
-    for ( int i = 0; i < MAX_POINTS; ++i )
+bool TimeVarInput::SetCurveKeys(const PODVector<Vector2> &points)
+{
+    if ( points.Size() < 2 || lineBatcher_ == NULL )
     {
-        IntVector2 btnPos = scrnPoints[ i ];
-        //btnPos.y_ = scrnSize.y_ - btnPos.y_;
+        return false;
+    }
 
-        btnPos.x_ = ( btnPos.x_ < 0)?0:(btnPos.x_ > scrnSize.x_)?scrnSize.x_:btnPos.x_;
-        btnPos.y_ = ( btnPos.y_ < 0)?0:(btnPos.y_ > scrnSize.y_)?scrnSize.y_:btnPos.y_;
+    unsigned numKeys = points.Size();
+    keyTimes_.Resize(numKeys);
+    keyValues_.Resize(numKeys);
 
-        if (i == 0)
-        {
-            btnPos.x_ = 0;
-        }
-        else if (i == buttonList_.Size() - 1)
-        {
-            btnPos.x_ = scrnSize.x_;
-        }
-        else
-        {
-            if (btnPos.x_ < buttonList_[i-1]->GetPosition().x_ + BUTTON_SPACING )
-            {
-                btnPos.x_ = buttonList_[i-1]->GetPosition().x_ + BUTTON_SPACING;
-            }
+    for ( unsigned i = 0; i < numKeys; ++i )
+    {
+        assert((i == 0 || points[i].x_ >= points[i - 1].x_) && "key times must be ascending");
 
-            if (btnPos.x_ > buttonList_[i+1]->GetPosition().x_ - BUTTON_SPACING)
-            {
-                btnPos.x_ = buttonList_[i+1]->GetPosition().x_ - BUTTON_SPACING;
-            }
-        }
+        keyTimes_[i] = points[i].x_;
+        keyValues_[i] = points[i].y_;
+    }
 
+    SetNumButtons(numKeys);
+
+    for ( unsigned i = 0; i < numKeys; ++i )
+    {
+        IntVector2 btnPos = KeyToButton(i);
         buttonList_[i]->SetPosition(btnPos);
         pointList_[i] = btnPos;
     }
 
     // updat draw line
     UpdateDrawLine();
+    UpdateCurve();
 
     return true;
 }
 
-void TimeVarInput::EvaluateCurvePoints(const PODVector<Vector2> &points, PODVector<IntVector2> &outPoints)
+void TimeVarInput::EvaluateCurvePoints(const PODVector<Vector2> &points)
 {
     float rmin=1e19f;
     float rmax=-1e19f;
@@ -275,25 +361,19 @@ void TimeVarInput::EvaluateCurvePoints(const PODVector<Vector2> &points, PODVect
         if (points[i].y_ > rmax) rmax = points[i].y_;
     }
 
-    SetValueRange(rmin, rmax);
-    SetTimeRange(tmin, tmax);
-    CurvePointsNormalized(points, outPoints);
-}
-
-void TimeVarInput::CurvePointsNormalized(const PODVector<Vector2> &points, PODVector<IntVector2> &scrnPoints)
-{
-    scrnPoints.Resize(MAX_POINTS);
-    IntVector2 scrnSize = GetSize() - controlBoxSize_;
-    Vector2 fscrnSize((float)scrnSize.x_, (float)scrnSize.y_);
+    assert(rmax > rmin);
+    assert(tmin >= 0.0f);
+    assert(tmax >= 0.1f);
 
-    for ( int i = 0; i < MAX_POINTS; ++i )
-    {
-        Vector2 p = points[ i ];
-        p.x_ =  fscrnSize.x_ * ((float)p.x_/timeRange_); 
-        p.y_ =  fscrnSize.y_ - fscrnSize.y_ * (p.y_ - minValue_)/valueRange_;
+    // the keys are set next, no need to rebuild them from the buttons
+    minValue_ = rmin;
+    maxValue_ = rmax;
+    valueRange_ = maxValue_ - minValue_;
+    timeStart_ = tmin;
+    timeEnd_ = tmax;
+    timeRange_ = tmax - tmin;
 
-        scrnPoints[ i ] = IntVector2((int)p.x_, (int)p.y_);
-    }
+    UpdateRangeText();
 }
 
 void TimeVarInput::SetValueRange(float rmin, float rmax)
@@ -305,11 +385,8 @@ void TimeVarInput::SetValueRange(float rmin, float rmax)
 
     valueRange_ = maxValue_ - minValue_;
 
-    char buff[20];
-    sprintf(buff, "%.1f", minValue_);
-    textMinValue_->SetText( String(buff) );
-    sprintf(buff, "%.1f", maxValue_);
-    textMaxValue_->SetText( String(buff) );
+    UpdateRangeText();
+    UpdateKeysFromButtons();
 }
 
 void TimeVarInput::SetTimeRange(float mintime, float maxtime)
@@ -321,10 +398,20 @@ void TimeVarInput::SetTimeRange(float mintime, float maxtime)
     timeEnd_ = maxtime;
     timeRange_ = maxtime - mintime;
 
+    UpdateRangeText();
+    UpdateKeysFromButtons();
+}
+
+void TimeVarInput::UpdateRangeText()
+{
     char buff[20];
-    sprintf(buff, "%.2f", mintime);
+    sprintf(buff, "%.1f", minValue_);
+    textMinValue_->SetText( String(buff) );
+    sprintf(buff, "%.1f", maxValue_);
+    textMaxValue_->SetText( String(buff) );
+    sprintf(buff, "%.2f", timeStart_);
     textTimeStart_->SetText( String(buff) );
-    sprintf(buff, "%.2f", maxtime);
+    sprintf(buff, "%.2f", timeEnd_);
     textTimeEnd_->SetText( String(buff) );
 }
 
@@ -365,22 +452,37 @@ void TimeVarInput::HandleButtonDragMove(StringHash eventType, VariantMap& eventD
             }
             else
             {
-                if (btnPos.x_ < buttonList_[i-1]->GetPosition().x_ + BUTTON_SPACING )
+                // dense keys can sit closer than the spacing, never pass a neighbor
+                int prevX = buttonList_[i-1]->GetPosition().x_;
+                int nextX = buttonList_[i+1]->GetPosition().x_;
+                int spacing = Min(BUTTON_SPACING, (nextX - prevX)/2);
+
+                if (btnPos.x_ < prevX + spacing )
                 {
-                    btnPos.x_ = buttonList_[i-1]->GetPosition().x_ + BUTTON_SPACING;
+                    btnPos.x_ = prevX + spacing;
                 }
 
-                if (btnPos.x_ > buttonList_[i+1]->GetPosition().x_ - BUTTON_SPACING)
+                if (btnPos.x_ > nextX - spacing)
                 {
-                    btnPos.x_ = buttonList_[i+1]->GetPosition().x_ - BUTTON_SPACING;
+                    btnPos.x_ = nextX - spacing;
                 }
             }
             button->SetPosition(btnPos);
+
+            ButtonToKey(i);
+
+            // pixel rounding must not reorder the keys
+            if ( i > 0 && keyTimes_[i] < keyTimes_[i-1] )
+                keyTimes_[i] = keyTimes_[i-1];
+            if ( i + 1 < keyTimes_.Size() && keyTimes_[i] > keyTimes_[i+1] )
+                keyTimes_[i] = keyTimes_[i+1];
+            break;
         }
     }
 
     // updat draw line
     UpdateDrawLine();
+    UpdateCurve();
 }
 
 void TimeVarInput::HandleLayoutUpdated(StringHash eventType, VariantMap& eventData)
@@ -391,22 +493,82 @@ void TimeVarInput::HandleLayoutUpdated(StringHash eventType, VariantMap& eventDa
 void TimeVarInput::UpdateDrawLine()
 {
     IntVector2 absPos = GetScreenPosition();
-    IntVector2 scrnSize = GetSize() - controlBoxSize_;
-
-    spline_.Clear();
 
     for ( unsigned i = 0; i < buttonList_.Size(); ++i )
     {
         IntVector2 btnPos = buttonList_[i]->GetPosition();
         absolutePositionList_[i] = btnPos + absPos + controlBoxSize_/2;
-
-        Vector2 v0((float)btnPos.x_, (float)(scrnSize.y_ - btnPos.y_));
-        spline_.AddKnot( v0 );
     }
 
     lineBatcher_->DrawPoints(absolutePositionList_);
 }
 
+void TimeVarInput::UpdateCurve()
+{
+    // rebakes the model curve, only needed when the keys change
+    GetModel()->SetCurve(modelPort_, keyTimes_, keyValues_, timeStart_, timeEnd_);
+}
+
+const TimeCurve* TimeVarInput::GetCurve()
+{
+    return GetModel()->GetCurve(modelPort_);
+}
+
+float TimeVarInput::GetValueAtTime(float time)
+{
+    const TimeCurve *curve = GetCurve();
+
+    return curve ? curve->Sample(time) : 0.0f;
+}
+
+void TimeVarInput::SetCurveResolution(unsigned resolution)
+{
+    GetModel()->SetCurveResolution(modelPort_, resolution);
+}
+
+void TimeVarInput::UpdateKeysFromButtons()
+{
+    // the buttons stay put when a range changes, their keys follow
+    keyTimes_.Resize(buttonList_.Size());
+    keyValues_.Resize(buttonList_.Size());
+
+    for ( unsigned i = 0; i < buttonList_.Size(); ++i )
+    {
+        ButtonToKey(i);
+    }
+
+    UpdateCurve();
+}
+
+void TimeVarInput::ButtonToKey(unsigned idx)
+{
+    // buttons are in screen space with y down, x maps to the absolute times
+    // timeStart_..timeEnd_ like the keys of SetCurveKeys(), the inverse of KeyToButton()
+    IntVector2 scrnSize = GetSize() - controlBoxSize_;
+    IntVector2 btnPos = buttonList_[idx]->GetPosition();
+
+    float pctTime = scrnSize.x_ > 0 ? (float)btnPos.x_ / (float)scrnSize.x_ : 0.0f;
+    float pctScale = scrnSize.y_ > 0 ? (float)(scrnSize.y_ - btnPos.y_) / (float)scrnSize.y_ : 0.0f;
+
+    keyTimes_[idx] = timeRange_ * pctTime + timeStart_;
+    keyValues_[idx] = valueRange_ * pctScale + minValue_;
+}
+
+IntVector2 TimeVarInput::KeyToButton(unsigned idx) const
+{
+    IntVector2 scrnSize = GetSize() - controlBoxSize_;
+    Vector2 fscrnSize((float)scrnSize.x_, (float)scrnSize.y_);
+
+    float x = timeRange_ > 0.0f ? fscrnSize.x_ * (keyTimes_[idx] - timeStart_)/timeRange_ : 0.0f;
+    float y = fscrnSize.y_ - fscrnSize.y_ * (keyValues_[idx] - minValue_)/valueRange_;
+
+    IntVector2 btnPos((int)x, (int)y);
+    btnPos.x_ = ( btnPos.x_ < 0)?0:(btnPos.x_ > scrnSize.x_)?scrnSize.x_:btnPos.x_;
+    btnPos.y_ = ( btnPos.y_ < 0)?0:(btnPos.y_ > scrnSize.y_)?scrnSize.y_:btnPos.y_;
+
+    return btnPos;
+}
+
 float TimeVarInput::GetValueRangeMin(const String &varName)
 {
     if ( varName == variableName_ )
@@ -443,20 +605,6 @@ float TimeVarInput::GetEndTime(const String &varName)
     return 0.0f;
 }
 
-float TimeVarInput::GetValueAtTime(float time)
-{
-    float atTime = time<timeStart_?timeStart_:time>timeEnd_?timeEnd_:time;
-    atTime /= timeRange_;
-
-    IntVector2 scrnSize = GetSize() - controlBoxSize_;
-    Vector2 scrn((float)scrnSize.x_, (float)scrnSize.y_);
-    Vector2 v1 = spline_.GetPoint( atTime ).GetVector2();
-    float pctScale = ((float)v1.y_) / (float)scrn.y_;
-    float val = valueRange_ * pctScale + minValue_;
-
-    return val;
-}
-
 float TimeVarInput::GetValueAtTime(const String &varName, float time)
 {
     if ( varName == variableName_ )
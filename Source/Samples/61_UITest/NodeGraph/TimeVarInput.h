@@ -20,23 +20,14 @@
 // THE SOFTWARE.
 //
 #pragma once
-#include <Urho3D/Core/Spline.h>
-
 #include "IOElement.h"
 #include "LineBatcher.h"
 
-//=============================================================================
-//=============================================================================
-enum MaxPoint
-{
-    MAX_POINTS = 5
-};
-
 //=============================================================================
 //=============================================================================
 class TimeVarInput : public IOElement
 {
-    URHO3D_OBJECT(TimeVarInput, GraphNode);
+    URHO3D_OBJECT(TimeVarInput, IOElement);
 public:
     static void RegisterObject(Context* context);
 
@@ -51,26 +42,54 @@ public:
     virtual float GetEndTime(const String &varName);
     virtual float GetValueAtTime(const String &varName, float time);
 
+    // the curve lives in the GraphPlan model, NULL until placed in a node
+    const TimeCurve* GetCurve();
+    float GetValueAtTime(float time);
+    void SetCurveResolution(unsigned resolution);
+    float GetTimeStart() const { return timeStart_; }
+    float GetTimeEnd() const   { return timeEnd_;   }
+
+    // points are (time, value) keys with ascending times, any count from 2 up.
+    // InitDataCurvePoints also fits the ranges to the points, SetCurveKeys keeps them
     bool InitDataCurvePoints(const PODVector<Vector2> &points);
+    bool SetCurveKeys(const PODVector<Vector2> &points);
+    unsigned GetNumKeys() const { return keyTimes_.Size(); }
     void SetValueRange(float rmin, float rmax);
     void SetTimeRange(float mintime, float maxtime);
 
+    // restored from a page snapshot
+    virtual void ApplyAttributes();
+    Vector2 GetValueRangeAttr() const { return Vector2(minValue_, maxValue_); }
+    void SetValueRangeAttr(const Vector2 &range);
+    Vector2 GetTimeRangeAttr() const  { return Vector2(timeStart_, timeEnd_); }
+    void SetTimeRangeAttr(const Vector2 &range);
+    VariantVector GetCurvePointsAttr() const;
+    void SetCurvePointsAttr(const VariantVector &points);
+
 protected:
+    virtual GraphPortType GetModelPortType() const { return PORTTYPE_CURVE; }
+    virtual void UpdateModelPort() { UpdateCurve(); }
+
     bool InitInternal();
     bool InitScreen(const IntVector2 &size);
     Text* CreateText(int size, const IntVector2 &pos);
     bool CreateButtons();
+    Button* CreateButton();
+    void SetNumButtons(unsigned num);
     bool CreateLineBatcher(LineType linetype, const Color& color, float pixelSize);
 
-    void EvaluateCurvePoints(const PODVector<Vector2> &points, PODVector<IntVector2> &outPoints);
-    void CurvePointsNormalized(const PODVector<Vector2> &points, PODVector<IntVector2> &scrnPoints);
+    void EvaluateCurvePoints(const PODVector<Vector2> &points);
+    void UpdateRangeText();
 
     void HandleBaseDragMove(StringHash eventType, VariantMap& eventData);
     void HandleButtonDragMove(StringHash eventType, VariantMap& eventData);
     void HandleLayoutUpdated(StringHash eventType, VariantMap& eventData);
 
     void  UpdateDrawLine();
-    float GetValueAtTime(float time);
+    void  UpdateCurve();
+    void  UpdateKeysFromButtons();
+    void  ButtonToKey(unsigned idx);
+    IntVector2 KeyToButton(unsigned idx) const;
 
 protected:
     WeakPtr<Text>         textTitle_;
@@ -88,7 +107,9 @@ protected:
     PODVector<IntVector2> pointList_;
     IntVector2            controlBoxSize_;
 
-    Spline                spline_;
+    // the keys are the curve data in absolute time, the buttons only show them
+    PODVector<float>      keyTimes_;
+    PODVector<float>      keyValues_;
 
     float                 minValue_;
     float                 maxValue_;
@@ -97,6 +118,9 @@ protected:
     float                 timeStart_;
     float                 timeEnd_;
     float                 timeRange_;
+
+    // keys read from a snapshot, applied in ApplyAttributes()
+    PODVector<Vector2>    restoredKeyList_;
 };
 
 
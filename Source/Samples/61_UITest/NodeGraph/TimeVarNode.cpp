@@ -35,6 +35,7 @@
 void TimeVarNode::RegisterObject(Context* context)
 {
     context->RegisterFactory<TimeVarNode>(UI_CATEGORY);
+    URHO3D_COPY_BASE_ATTRIBUTES(GraphNode);
 }
 
 TimeVarNode::TimeVarNode(Context *context) 
@@ -48,6 +49,20 @@ TimeVarNode::~TimeVarNode()
 {
 }
 
+void TimeVarNode::ApplyAttributes()
+{
+    // the io elements created in the constructor were replaced by the restored ones
+    if ( timeVarInput_ == NULL )
+    {
+        timeVarInput_ = (TimeVarInput*)FindIOElement(TimeVarInput::GetTypeStatic());
+    }
+
+    if ( outputNode_ == NULL )
+    {
+        outputNode_ = (OutputNode*)FindIOElement(OutputNode::GetTypeStatic());
+    }
+}
+
 bool TimeVarNode::CreateTimeVarInput(const String &variableName, const IntVector2 &size)
 {
     if ( !timeVarInput_->Create(variableName, size) )
@@ -51,6 +51,9 @@ public:
     void SetEnableCtrlButton(bool enable);
     bool ConnectToInput(InputNode *inputNode);
 
+    // restored from a page snapshot
+    virtual void ApplyAttributes();
+
 protected:
     WeakPtr<TimeVarInput> timeVarInput_;
     WeakPtr<OutputNode>   outputNode_;
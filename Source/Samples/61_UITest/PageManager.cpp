@@ -28,7 +28,11 @@
 #include <Urho3D/UI/Font.h>
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/UI/CheckBox.h>
+#include <Urho3D/UI/Slider.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
 #include <Urho3D/Graphics/Texture2D.h>
 
 #include "PageManager.h"
@@ -40,14 +44,249 @@
 const Color ENABLEDColor(0.0f, 0.8f, 0.9f, 0.9f);
 const Color DISABLEDColor(0.0f, 0.5f, 0.6f, 0.9f);
 
+const unsigned PAGE_SNAPSHOT_VERSION = 1;
+
+//=============================================================================
+//=============================================================================
+void PageRoot::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PageRoot>();
+}
+
+PageRoot::PageRoot(Context *context)
+    : UIElement(context)
+    , frozen_(false)
+    , batchesDirty_(true)
+{
+}
+
+PageRoot::~PageRoot()
+{
+}
+
+void PageRoot::SetFrozen(bool freeze)
+{
+    if (freeze == frozen_)
+        return;
+
+    frozen_ = freeze;
+    batchesDirty_ = true;
+
+    // a zero sized clip region stops the UI from walking the page elements,
+    // input still reaches them since picking ignores the clip border
+    SetClipChildren(freeze);
+    SetClipBorder(freeze ? IntRect(0, 0, GetSize().x_, 0) : IntRect::ZERO);
+
+    if (!freeze)
+    {
+        batchCache_.Clear();
+        vertexCache_.Clear();
+    }
+}
+
+bool PageRoot::IsInteracting()
+{
+    UI* ui = GetSubsystem<UI>();
+
+    // hover and focus state (e.g. the line edit cursor) change without events,
+    // and an element's hover flag is only cleared in its GetBatches()
+    UIElement *element = ui->GetFocusElement();
+
+    while (element && element != this)
+        element = element->GetParent();
+
+    if (element)
+        return true;
+
+    element = ui->GetElementAt(ui->GetCursorPosition());
+
+    while (element && element != this)
+        element = element->GetParent();
+
+    return (element != NULL);
+}
+
+void PageRoot::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
+{
+    UIElement::GetBatches(batches, vertexData, currentScissor);
+
+    if (!frozen_)
+        return;
+
+    if (batchesDirty_ || IsInteracting())
+    {
+        batchCache_.Clear();
+        vertexCache_.Clear();
+
+        CollectBatches(this, batchCache_, vertexCache_, currentScissor);
+        batchesDirty_ = false;
+    }
+
+    // replay
+    unsigned vertexOffset = vertexData.Size();
+    vertexData.Push(vertexCache_);
+
+    for ( unsigned i = 0; i < batchCache_.Size(); ++i )
+    {
+        UIBatch batch = batchCache_[i];
+        batch.vertexData_   = &vertexData;
+        batch.vertexStart_ += vertexOffset;
+        batch.vertexEnd_   += vertexOffset;
+
+        UIBatch::AddOrMerge(batch, batches);
+    }
+
+    GetLiveBatches(batches, vertexData, currentScissor);
+}
+
+void PageRoot::SetElementLive(UIElement *element, bool live)
+{
+    if (!element)
+        return;
+
+    for ( unsigned i = 0; i < liveElements_.Size(); ++i )
+    {
+        if (liveElements_[i] == element)
+        {
+            if (!live)
+            {
+                liveElements_.Erase(i);
+                batchesDirty_ = true;
+            }
+            return;
+        }
+    }
+
+    if (live)
+    {
+        liveElements_.Push(WeakPtr<UIElement>(element));
+        batchesDirty_ = true;
+    }
+}
+
+bool PageRoot::IsLiveElement(UIElement *element) const
+{
+    for ( unsigned i = 0; i < liveElements_.Size(); ++i )
+    {
+        if (liveElements_[i] == element)
+            return true;
+    }
+
+    return false;
+}
+
+bool PageRoot::IsInLiveElement(UIElement *element) const
+{
+    while (element && element != this)
+    {
+        if (IsLiveElement(element))
+            return true;
+
+        element = element->GetParent();
+    }
+
+    return false;
+}
+
+void PageRoot::GetLiveBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
+{
+    for ( unsigned i = 0; i < liveElements_.Size(); ++i )
+    {
+        UIElement *element = liveElements_[i];
+
+        if (!element || !element->IsVisibleEffective())
+            continue;
+
+        // scissor of the parents, top down
+        PODVector<UIElement*> parents;
+
+        for ( UIElement *parent = element->GetParent(); parent && parent != this; parent = parent->GetParent() )
+            parents.Push(parent);
+
+        IntRect scissor = currentScissor;
+
+        for ( unsigned j = parents.Size(); j > 0; --j )
+            parents[j - 1]->AdjustScissor(scissor);
+
+        if (element->IsWithinScissor(scissor))
+            element->GetBatches(batches, vertexData, scissor);
+
+        CollectBatches(element, batches, vertexData, scissor);
+    }
+}
+
+void PageRoot::CollectBatches(UIElement *element, PODVector<UIBatch>& batches, PODVector<float>& vertexData, IntRect currentScissor)
+{
+    // same traversal as UI::GetBatches() except that the page's own clip border is skipped
+    if (element != this)
+    {
+        element->AdjustScissor(currentScissor);
+
+        if (currentScissor.left_ == currentScissor.right_ || currentScissor.top_ == currentScissor.bottom_)
+            return;
+    }
+
+    element->SortChildren();
+    const Vector<SharedPtr<UIElement> >& children = element->GetChildren();
+
+    if (children.Empty())
+        return;
+
+    Vector<SharedPtr<UIElement> >::ConstIterator i = children.Begin();
+
+    if (element->GetTraversalMode() == TM_BREADTH_FIRST)
+    {
+        // draw all children of the same priority before recursing into their children
+        Vector<SharedPtr<UIElement> >::ConstIterator j = i;
+
+        while (i != children.End())
+        {
+            int currentPriority = (*i)->GetPriority();
+
+            while (j != children.End() && (*j)->GetPriority() == currentPriority)
+            {
+                if ((*j)->IsWithinScissor(currentScissor) && !IsLiveElement(*j))
+                    (*j)->GetBatches(batches, vertexData, currentScissor);
+                ++j;
+            }
+
+            while (i != j)
+            {
+                if ((*i)->IsVisible() && !IsLiveElement(*i))
+                    CollectBatches(*i, batches, vertexData, currentScissor);
+                ++i;
+            }
+        }
+    }
+    else
+    {
+        while (i != children.End())
+        {
+            if (!IsLiveElement(*i))
+            {
+                if ((*i)->IsWithinScissor(currentScissor))
+                    (*i)->GetBatches(batches, vertexData, currentScissor);
+                if ((*i)->IsVisible())
+                    CollectBatches(*i, batches, vertexData, currentScissor);
+            }
+            ++i;
+        }
+    }
+}
+
 //=============================================================================
 //=============================================================================
 void PageManager::RegisterObject(Context* context)
 {
     context->RegisterSubsystem( new PageManager(context) );
+    PageRoot::RegisterObject(context);
 }
 
-PageManager::PageManager(Context *context) : Object(context)
+PageManager::PageManager(Context *context) 
+    : Object(context)
+    , currentPageIdx_(0)
+    , visitCounter_(0)
+    , elementBudget_(M_MAX_UNSIGNED)
 {
 }
 
@@ -102,12 +341,16 @@ bool PageManager::CreatePages(int numPages)
     // create pages
     for ( int i = 0; i < numPages; ++i )
     {
-        UIElement *page = root->CreateChild<UIElement>();
+        PageRoot *page = root->CreateChild<PageRoot>();
         page->SetSize(rootSize_);
         page->SetVisible(i==0);
         pageList_.Push(page);
     }
 
+    pageDescList_.Resize(pageList_.Size());
+
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(PageManager, HandleResourceBackgroundLoaded));
+
     return true;
 }
 
@@ -151,19 +394,534 @@ void PageManager::SetPageIndex(int idx)
 {
     if (idx < (int)pageList_.Size())
     {
+        int prevIdx = currentPageIdx_;
+
+        if (prevIdx != idx)
+        {
+            NotifyPageActive(prevIdx, false);
+            SendPageEvent(E_PAGEDEACTIVATED, prevIdx);
+        }
+
         GetPageRoot(currentPageIdx_)->SetVisible(false);
         currentPageIdx_ = idx;
+
+        // a page still waiting on its prefetch is built once the loads complete,
+        // see HandleResourceBackgroundLoaded(). only queued loads are pending,
+        // they all send the event, failed ones included
+        if ( !pageDescList_[idx].built_ && pageDescList_[idx].pendingResources_.Empty() )
+        {
+            BuildPage(idx);
+        }
+
         GetPageRoot(currentPageIdx_)->SetVisible(true);
+        pageDescList_[idx].lastVisit_ = ++visitCounter_;
+
+        if (prevIdx != idx)
+        {
+            NotifyPageActive(idx, true);
+            SendPageEvent(E_PAGEACTIVATED, idx);
+        }
+
+        EnforceElementBudget();
+
+        if (idx > 0)
+            PrefetchPage(idx - 1);
+        if (idx + 1 < (int)pageList_.Size())
+            PrefetchPage(idx + 1);
     }
 
     UpdateButtonState(currentPageIdx_);
 }
 
+void PageManager::SetPageBuilder(unsigned idx, Object *builder, PageBuildCallback callback)
+{
+    if (idx < pageDescList_.Size())
+    {
+        pageDescList_[idx].builder_ = builder;
+        pageDescList_[idx].pfnBuildCallback_ = callback;
+    }
+}
+
+bool PageManager::IsPageBuilt(unsigned idx) const
+{
+    return idx < pageDescList_.Size() && pageDescList_[idx].built_;
+}
+
+unsigned PageManager::GetNumPageElements() const
+{
+    unsigned count = 0;
+
+    for ( unsigned i = 0; i < pageList_.Size(); ++i )
+    {
+        count += pageList_[i]->GetNumChildren(true);
+    }
+
+    return count;
+}
+
+void PageManager::AddPageResource(unsigned idx, StringHash type, const String &name)
+{
+    if (idx < pageDescList_.Size())
+    {
+        String resName = GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+        pageDescList_[idx].resourceList_.Push(MakePair(type, resName));
+    }
+}
+
+void PageManager::PrefetchPage(unsigned idx)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    PageDesc &desc = pageDescList_[idx];
+
+    if (desc.built_)
+        return;
+
+    for ( unsigned i = 0; i < desc.resourceList_.Size(); ++i )
+    {
+        StringHash type = desc.resourceList_[i].first_;
+        const String &name = desc.resourceList_[i].second_;
+
+        if (desc.pendingResources_.Contains(name) || cache->GetExistingResource(type, name))
+            continue;
+
+        // only track loads that were queued: false means already queued or failed,
+        // and without threading the resource is loaded synchronously here
+        if (cache->BackgroundLoadResource(type, name) && !cache->GetExistingResource(type, name))
+            desc.pendingResources_.Insert(name);
+    }
+}
+
+void PageManager::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    const String &name = eventData[P_RESOURCENAME].GetString();
+
+    // failed loads are also removed, the page then loads them itself
+    for ( unsigned i = 0; i < pageDescList_.Size(); ++i )
+    {
+        pageDescList_[i].pendingResources_.Erase(name);
+    }
+
+    PageDesc &desc = pageDescList_[currentPageIdx_];
+
+    if (!desc.built_ && desc.pendingResources_.Empty())
+    {
+        BuildPage(currentPageIdx_);
+        EnforceElementBudget();
+    }
+}
+
+void PageManager::BuildPage(unsigned idx)
+{
+    PageDesc &desc = pageDescList_[idx];
+
+    // pages without a builder are filled directly through GetRoot()
+    desc.built_ = true;
+    pageList_[idx]->MarkBatchesDirty();
+
+    if (desc.builder_ && desc.pfnBuildCallback_)
+    {
+        // GetRoot() returns this page while the builder runs
+        int prevIdx = currentPageIdx_;
+        currentPageIdx_ = idx;
+
+        if (!RestorePage(idx))
+        {
+            (desc.builder_->*desc.pfnBuildCallback_)();
+
+            if (!desc.snapshotFile_.Empty())
+            {
+                File file(context_, desc.snapshotFile_, FILE_WRITE);
+                SavePage(idx, file, desc.snapshotVersion_);
+            }
+        }
+
+        currentPageIdx_ = prevIdx;
+    }
+}
+
+bool PageManager::RestorePage(unsigned idx)
+{
+    PageDesc &desc = pageDescList_[idx];
+
+    if (desc.snapshotFile_.Empty() || !GetSubsystem<FileSystem>()->FileExists(desc.snapshotFile_))
+        return false;
+
+    File file(context_, desc.snapshotFile_);
+
+    if (!LoadPage(idx, file, desc.snapshotVersion_))
+        return false;
+
+    // reattach what only code can create, e.g. callbacks
+    if (desc.pfnRestoreCallback_)
+    {
+        (desc.builder_->*desc.pfnRestoreCallback_)();
+    }
+
+    return true;
+}
+
+void PageManager::SetPageSnapshotFile(unsigned idx, const String &fileName, unsigned version, PageBuildCallback restoreCallback)
+{
+    if (idx < pageDescList_.Size())
+    {
+        pageDescList_[idx].snapshotFile_ = fileName;
+        pageDescList_[idx].snapshotVersion_ = version;
+        pageDescList_[idx].pfnRestoreCallback_ = restoreCallback;
+    }
+}
+
+bool PageManager::SavePage(unsigned idx, Serializer &dest, unsigned version)
+{
+    if (idx >= pageList_.Size())
+        return false;
+
+    // ids follow the order the elements are written in
+    snapshotIds_.Clear();
+    AssignSnapshotIds(pageList_[idx]);
+
+    bool success = dest.WriteFileID("UPSN") &&
+                   dest.WriteUInt(PAGE_SNAPSHOT_VERSION) &&
+                   dest.WriteUInt(version) &&
+                   SaveChildren(pageList_[idx], dest);
+
+    snapshotIds_.Clear();
+
+    return success;
+}
+
+bool PageManager::LoadPage(unsigned idx, Deserializer &source, unsigned version)
+{
+    if (idx >= pageList_.Size())
+        return false;
+
+    if (source.ReadFileID() != "UPSN" || source.ReadUInt() != PAGE_SNAPSHOT_VERSION || source.ReadUInt() != version)
+        return false;
+
+    // GetRoot() returns this page while the widgets recreate their helpers
+    int prevIdx = currentPageIdx_;
+    currentPageIdx_ = idx;
+
+    PageRoot *page = pageList_[idx];
+    page->RemoveAllChildren();
+    snapshotElements_.Clear();
+
+    bool success = LoadChildren(page, source);
+
+    if (success)
+    {
+        // children before their parents, widgets rebuild what they don't save
+        for ( int i = (int)snapshotElements_.Size() - 1; i >= 0; --i )
+        {
+            if (snapshotElements_[i])
+                snapshotElements_[i]->ApplyAttributes();
+        }
+
+        SendPageEvent(E_PAGERESTORED, idx);
+    }
+    else
+    {
+        page->RemoveAllChildren();
+    }
+
+    snapshotElements_.Clear();
+    page->MarkBatchesDirty();
+    currentPageIdx_ = prevIdx;
+
+    return success;
+}
+
+int PageManager::GetSnapshotId(UIElement *element) const
+{
+    HashMap<UIElement*, unsigned>::ConstIterator it = snapshotIds_.Find(element);
+
+    return (it != snapshotIds_.End()) ? (int)it->second_ : -1;
+}
+
+UIElement* PageManager::GetSnapshotElement(int id) const
+{
+    return (id >= 0 && id < (int)snapshotElements_.Size()) ? snapshotElements_[id].Get() : NULL;
+}
+
+bool PageManager::IsSnapshotElement(UIElement *element) const
+{
+    return !element->IsTemporary() && context_->GetObjectFactories().Contains(element->GetType());
+}
+
+void PageManager::AssignSnapshotIds(UIElement *parent)
+{
+    const Vector<SharedPtr<UIElement> >& children = parent->GetChildren();
+
+    for ( unsigned i = 0; i < children.Size(); ++i )
+    {
+        if (IsSnapshotElement(children[i]))
+        {
+            unsigned id = snapshotIds_.Size();
+            snapshotIds_[children[i]] = id;
+            AssignSnapshotIds(children[i]);
+        }
+    }
+}
+
+bool PageManager::SaveChildren(UIElement *parent, Serializer &dest)
+{
+    const Vector<SharedPtr<UIElement> >& children = parent->GetChildren();
+    unsigned numChildren = 0;
+
+    for ( unsigned i = 0; i < children.Size(); ++i )
+    {
+        if (IsSnapshotElement(children[i]))
+            ++numChildren;
+    }
+
+    if (!dest.WriteVLE(numChildren))
+        return false;
+
+    for ( unsigned i = 0; i < children.Size(); ++i )
+    {
+        UIElement *child = children[i];
+
+        if (!IsSnapshotElement(child))
+            continue;
+
+        if (!dest.WriteStringHash(child->GetType()) || !child->Save(dest) || !SaveChildren(child, dest))
+            return false;
+    }
+
+    return true;
+}
+
+bool PageManager::LoadChildren(UIElement *parent, Deserializer &source)
+{
+    // children the parent created in its constructor are reused when the type matches
+    Vector<SharedPtr<UIElement> > existing = parent->GetChildren();
+    PODVector<bool> reused(existing.Size());
+    unsigned numChildren = source.ReadVLE();
+
+    for ( unsigned i = 0; i < reused.Size(); ++i )
+    {
+        reused[i] = false;
+    }
+
+    for ( unsigned i = 0; i < numChildren; ++i )
+    {
+        StringHash type = source.ReadStringHash();
+        UIElement *child = NULL;
+
+        if (i < existing.Size() && existing[i]->GetType() == type)
+        {
+            child = existing[i];
+            reused[i] = true;
+        }
+        else
+        {
+            child = parent->CreateChild(type);
+        }
+
+        if (child == NULL)
+            return false;
+
+        snapshotElements_.Push(WeakPtr<UIElement>(child));
+
+        if (!child->Load(source) || !LoadChildren(child, source))
+            return false;
+    }
+
+    // constructor children without a saved counterpart were moved elsewhere by their widget
+    for ( unsigned i = 0; i < existing.Size(); ++i )
+    {
+        if (!reused[i] && !existing[i]->IsTemporary())
+            parent->RemoveChild(existing[i]);
+    }
+
+    return true;
+}
+
+void PageManager::UnloadPage(unsigned idx)
+{
+    pageList_[idx]->RemoveAllChildren();
+    pageList_[idx]->MarkBatchesDirty();
+    pageDescList_[idx].built_ = false;
+}
+
+void PageManager::EnforceElementBudget()
+{
+    unsigned numElements = GetNumPageElements();
+
+    while (numElements > elementBudget_)
+    {
+        int lruIdx = -1;
+
+        // only pages that can be rebuilt are unloaded
+        for ( unsigned i = 0; i < pageDescList_.Size(); ++i )
+        {
+            const PageDesc &desc = pageDescList_[i];
+
+            if ((int)i == currentPageIdx_ || !desc.built_ || desc.builder_ == NULL)
+                continue;
+
+            if (lruIdx < 0 || desc.lastVisit_ < pageDescList_[lruIdx].lastVisit_)
+                lruIdx = i;
+        }
+
+        if (lruIdx < 0)
+            break;
+
+        numElements -= pageList_[lruIdx]->GetNumChildren(true);
+        UnloadPage(lruIdx);
+    }
+}
+
 int PageManager::GetPageIndex()
 {
     return currentPageIdx_;
 }
 
+void PageManager::SetPageFrozen(unsigned idx, bool freeze)
+{
+    if (idx >= pageList_.Size())
+        return;
+
+    pageList_[idx]->SetFrozen(freeze);
+
+    if (freeze)
+    {
+        // UI events that change how an element is drawn
+        SubscribeToEvent(E_POSITIONED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_RESIZED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_VISIBLECHANGED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_LAYOUTUPDATED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_HOVERBEGIN, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_HOVEREND, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_FOCUSED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_DEFOCUSED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_PRESSED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_RELEASED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_TOGGLED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_SLIDERCHANGED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+        SubscribeToEvent(E_TEXTCHANGED, URHO3D_HANDLER(PageManager, HandleElementChanged));
+    }
+}
+
+bool PageManager::IsPageFrozen(unsigned idx) const
+{
+    return idx < pageList_.Size() && pageList_[idx]->IsFrozen();
+}
+
+void PageManager::MarkPageDirty(UIElement *element)
+{
+    PageRoot *page = static_cast<PageRoot*>(FindPageRoot(element));
+
+    // live elements are drawn every frame anyway
+    if (page && page->IsFrozen() && !page->IsInLiveElement(element))
+    {
+        page->MarkBatchesDirty();
+    }
+}
+
+void PageManager::SetElementLive(UIElement *element, bool live)
+{
+    PageRoot *page = static_cast<PageRoot*>(FindPageRoot(element));
+
+    if (page)
+    {
+        page->SetElementLive(element, live);
+    }
+}
+
+void PageManager::HandleElementChanged(StringHash eventType, VariantMap& eventData)
+{
+    // all of the subscribed events carry the element in the same parameter
+    using namespace Positioned;
+
+    MarkPageDirty((UIElement*)eventData[P_ELEMENT].GetVoidPtr());
+}
+
+UIElement* PageManager::FindPageRoot(UIElement *element)
+{
+    while (element)
+    {
+        for ( unsigned i = 0; i < pageList_.Size(); ++i )
+        {
+            if (pageList_[i] == element)
+                return element;
+        }
+
+        element = element->GetParent();
+    }
+
+    return NULL;
+}
+
+bool PageManager::IsPageActive(UIElement *element)
+{
+    UIElement *page = FindPageRoot(element);
+
+    return (page == NULL || page == GetRoot());
+}
+
+void PageManager::AddPageActiveCallback(UIElement *element, PageActiveCallback callback)
+{
+    if (element == NULL || callback == NULL)
+        return;
+
+    RemovePageActiveCallback(element);
+
+    PageActiveListener listener;
+    listener.element_ = element;
+    listener.pfnCallback_ = callback;
+    pageActiveListeners_.Push(listener);
+}
+
+void PageManager::RemovePageActiveCallback(UIElement *element)
+{
+    for ( unsigned i = 0; i < pageActiveListeners_.Size(); ++i )
+    {
+        if (pageActiveListeners_[i].element_ == element)
+        {
+            pageActiveListeners_.Erase(i);
+            return;
+        }
+    }
+}
+
+void PageManager::NotifyPageActive(int idx, bool active)
+{
+    UIElement *page = GetPageRoot(idx);
+
+    // callbacks may add or remove listeners, work on a copy
+    Vector<PageActiveListener> listeners = pageActiveListeners_;
+
+    for ( unsigned i = 0; i < listeners.Size(); ++i )
+    {
+        UIElement *element = listeners[i].element_;
+
+        if (element && FindPageRoot(element) == page)
+        {
+            (element->*listeners[i].pfnCallback_)(active);
+        }
+    }
+
+    // drop the listeners of destroyed elements
+    for ( unsigned i = pageActiveListeners_.Size(); i > 0; --i )
+    {
+        if (pageActiveListeners_[i - 1].element_.Expired())
+            pageActiveListeners_.Erase(i - 1);
+    }
+}
+
+void PageManager::SendPageEvent(StringHash eventType, int idx)
+{
+    // both events share the same parameters
+    using namespace PageActivated;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_PAGE] = GetPageRoot(idx);
+    eventData[P_INDEX] = idx;
+    SendEvent(eventType, eventData);
+}
+
 void PageManager::HandleButtonReleased(StringHash eventType, VariantMap& eventData)
 {
     using namespace Released;
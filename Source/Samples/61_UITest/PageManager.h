@@ -21,6 +21,9 @@
 //
 #pragma once
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/UI/UIElement.h>
+#include <Urho3D/UI/UIBatch.h>
 //#include <Urho3D/UI/CheckBox.h>
 
 namespace Urho3D
@@ -29,6 +32,97 @@ extern const char* UI_CATEGORY;
 class Button;
 }
 using namespace Urho3D;
+
+URHO3D_EVENT(E_PAGEACTIVATED, PageActivated)
+{
+    URHO3D_PARAM(P_PAGE, Page);                    // UIElement pointer
+    URHO3D_PARAM(P_INDEX, Index);                  // int
+}
+
+URHO3D_EVENT(E_PAGEDEACTIVATED, PageDeactivated)
+{
+    URHO3D_PARAM(P_PAGE, Page);                    // UIElement pointer
+    URHO3D_PARAM(P_INDEX, Index);                  // int
+}
+
+// sent once a page snapshot is loaded, references between elements are resolved here
+URHO3D_EVENT(E_PAGERESTORED, PageRestored)
+{
+    URHO3D_PARAM(P_PAGE, Page);                    // UIElement pointer
+    URHO3D_PARAM(P_INDEX, Index);                  // int
+}
+
+// builds the content of the current page, PageManager::GetRoot() returns the page being built
+typedef void (Object::*PageBuildCallback)();
+
+// called on an element when its page is shown (true) or hidden (false)
+typedef void (Object::*PageActiveCallback)(bool active);
+
+struct PageActiveListener
+{
+    PageActiveListener() : pfnCallback_(NULL) {}
+
+    WeakPtr<UIElement> element_;
+    PageActiveCallback pfnCallback_;
+};
+
+struct PageDesc
+{
+    PageDesc() : builder_(NULL), pfnBuildCallback_(NULL), pfnRestoreCallback_(NULL), 
+        built_(false), lastVisit_(0), snapshotVersion_(0) {}
+
+    Object*           builder_;
+    PageBuildCallback pfnBuildCallback_;
+    PageBuildCallback pfnRestoreCallback_;
+    bool              built_;
+    unsigned          lastVisit_;
+
+    // built pages are saved here and restored from it on the next build
+    String            snapshotFile_;
+    unsigned          snapshotVersion_;
+
+    // resources used by the page, prefetched while an adjacent page is shown
+    Vector<Pair<StringHash, String> > resourceList_;
+    HashSet<String>   pendingResources_;
+};
+
+//=============================================================================
+// page root, a frozen page replays the batches captured from its elements
+// instead of letting the UI walk them every frame, live elements (animations)
+// are left out of the capture and drawn over it every frame
+//=============================================================================
+class PageRoot : public UIElement
+{
+    URHO3D_OBJECT(PageRoot, UIElement);
+public:
+    static void RegisterObject(Context* context);
+
+    PageRoot(Context *context);
+    virtual ~PageRoot();
+
+    void SetFrozen(bool freeze);
+    bool IsFrozen() const { return frozen_; }
+    void MarkBatchesDirty() { batchesDirty_ = true; }
+    void SetElementLive(UIElement *element, bool live);
+    bool IsInLiveElement(UIElement *element) const;
+
+    // virtual override
+    virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+
+protected:
+    bool IsInteracting();
+    bool IsLiveElement(UIElement *element) const;
+    void CollectBatches(UIElement *element, PODVector<UIBatch>& batches, PODVector<float>& vertexData, IntRect currentScissor);
+    void GetLiveBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+
+protected:
+    PODVector<UIBatch> batchCache_;
+    PODVector<float>   vertexCache_;
+    Vector<WeakPtr<UIElement> > liveElements_;
+    bool               frozen_;
+    bool               batchesDirty_;
+};
+
 //=============================================================================
 //=============================================================================
 class PageManager : public Object
@@ -49,16 +143,77 @@ public:
     void SetPageIndex(int idx);
     int GetPageIndex();
 
+    // page the element lives on, NULL for elements outside the pages (e.g. the control page)
+    UIElement* FindPageRoot(UIElement *element);
+    bool IsPageActive(UIElement *element);
+
+    // suspend/resume elements that only work while their page is shown,
+    // the callback isn't called for the current state
+    void AddPageActiveCallback(UIElement *element, PageActiveCallback callback);
+    void RemovePageActiveCallback(UIElement *element);
+
+    // frozen pages capture their batches once and replay them until an element on
+    // the page changes; components that change their look without sending a UI
+    // event call MarkPageDirty(), elements that change every frame are made live
+    void SetPageFrozen(unsigned idx, bool freeze);
+    bool IsPageFrozen(unsigned idx) const;
+    void MarkPageDirty(UIElement *element);
+    void SetElementLive(UIElement *element, bool live);
+
+    // lazy pages: the builder runs on the first visit, pages that can be rebuilt
+    // are torn down least recently visited first when over the element budget
+    void SetPageBuilder(unsigned idx, Object *builder, PageBuildCallback callback);
+    bool IsPageBuilt(unsigned idx) const;
+    void SetElementBudget(unsigned budget) { elementBudget_ = budget; }
+    unsigned GetElementBudget() const      { return elementBudget_; }
+    unsigned GetNumPageElements() const;
+
+    void AddPageResource(unsigned idx, StringHash type, const String &name);
+    template <class T> void AddPageResource(unsigned idx, const String &name) { AddPageResource(idx, T::GetTypeStatic(), name); }
+
+    // binary page snapshots: the element tree with the attributes of each element.
+    // temporary elements and types without a factory are left out, their owners
+    // recreate them in ApplyAttributes() or in the restore callback
+    bool SavePage(unsigned idx, Serializer &dest, unsigned version = 0);
+    bool LoadPage(unsigned idx, Deserializer &source, unsigned version = 0);
+    void SetPageSnapshotFile(unsigned idx, const String &fileName, unsigned version, PageBuildCallback restoreCallback);
+
+    // element references in attributes, valid while a page is saved or restored
+    int GetSnapshotId(UIElement *element) const;
+    UIElement* GetSnapshotElement(int id) const;
+
 protected:
     Button* CreateButton(const IntVector2 &pos, const IntRect &rect, const Color &color);
     void UpdateButtonState(int idx);
+    void BuildPage(unsigned idx);
+    bool RestorePage(unsigned idx);
+    bool IsSnapshotElement(UIElement *element) const;
+    void AssignSnapshotIds(UIElement *parent);
+    bool SaveChildren(UIElement *parent, Serializer &dest);
+    bool LoadChildren(UIElement *parent, Deserializer &source);
+    void UnloadPage(unsigned idx);
+    void EnforceElementBudget();
+    void PrefetchPage(unsigned idx);
+    void SendPageEvent(StringHash eventType, int idx);
+    void NotifyPageActive(int idx, bool active);
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    void HandleElementChanged(StringHash eventType, VariantMap& eventData);
     void HandleButtonReleased(StringHash eventType, VariantMap& eventData);
 
 protected:
     WeakPtr<UIElement> controlPage_;
-    Vector<UIElement*> pageList_;
+    Vector<PageRoot*>  pageList_;
+    Vector<PageDesc>   pageDescList_;
     IntVector2         rootSize_;
     int                currentPageIdx_;
+    unsigned           visitCounter_;
+    unsigned           elementBudget_;
+
+    Vector<PageActiveListener> pageActiveListeners_;
+
+    // snapshot element ids
+    HashMap<UIElement*, unsigned> snapshotIds_;
+    Vector<WeakPtr<UIElement> >   snapshotElements_;
 
     // buttons
     WeakPtr<Button>    buttonPrev_;
@@ -21,17 +21,24 @@
 //
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Input/InputEvents.h>
+#include <Urho3D/UI/UI.h>
 #include <Urho3D/UI/UIEvents.h>
 #include <Urho3D/UI/Button.h>
 #include <Urho3D/UI/BorderImage.h>
 #include <Urho3D/UI/Font.h>
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/UI/CheckBox.h>
+#include <Urho3D/UI/ScrollBar.h>
 #include <Urho3D/Resource/ResourceCache.h>
 
 #include "RadialGroup.h"
 
 #include <Urho3D/DebugNew.h>
+//=============================================================================
+//=============================================================================
+static const StringHash VAR_RADIAL_ROW("RadialRow");
+
 //=============================================================================
 //=============================================================================
 void RadialText::RegisterObject(Context* context)
@@ -57,6 +64,9 @@ void RadialGroup::RegisterObject(Context* context)
 
 RadialGroup::RadialGroup(Context *context) 
     : BorderImage(context)
+    , selectedIdx_(0)
+    , virtual_(false)
+    , firstOption_(0)
 {
     SetLayoutMode(LM_VERTICAL);
     SetLayoutBorder(IntRect(4,4,4,4));
@@ -83,8 +93,9 @@ RadialGroup::~RadialGroup()
 RadialElement* RadialGroup::CreateRadialButton()
 {
     RadialElement radElem;
+    UIElement *parent = rowsElement_ ? rowsElement_ : bodyElement_;
 
-    UIElement *element = bodyElement_->CreateChild<UIElement>();
+    UIElement *element = parent->CreateChild<UIElement>();
     radElem.bodyElement_ = element;
     element->SetLayoutBorder(IntRect(10,4,4,4));
     element->SetFocusMode(FM_FOCUSABLE_DEFOCUSABLE);
@@ -95,9 +106,11 @@ RadialElement* RadialGroup::CreateRadialButton()
     radElem.checkbox_ = element->CreateChild<CheckBox>();
     radElem.checkbox_->SetStyleAuto();
     radElem.checkbox_->SetImageRect(IntRect(208, 96, 224, 112));
-    radElem.checkbox_->SetChecked(childList_.Size() == 0);
+    radElem.checkbox_->SetChecked(!virtual_ && childList_.Size() == (unsigned)selectedIdx_);
+    radElem.checkbox_->SetVar(VAR_RADIAL_ROW, childList_.Size());
 
     radElem.textDesc_ = element->CreateChild<RadialText>();
+    radElem.textDesc_->SetVar(VAR_RADIAL_ROW, childList_.Size());
     childList_.Push(radElem);
 
     return &childList_.Back();
@@ -115,6 +128,142 @@ RadialElement* RadialGroup::GetRadialButtonDesc(unsigned idx)
     return desc;
 }
 
+void RadialGroup::SetVirtual(unsigned numRows)
+{
+    if ( virtual_ )
+        return;
+
+    virtual_ = true;
+
+    // rows on the left, scrollbar on the right
+    bodyElement_->SetLayoutMode(LM_HORIZONTAL);
+
+    rowsElement_ = bodyElement_->CreateChild<UIElement>();
+    rowsElement_->SetLayoutMode(LM_VERTICAL);
+
+    scrollBar_ = bodyElement_->CreateChild<ScrollBar>();
+    scrollBar_->SetStyleAuto();
+    scrollBar_->SetOrientation(O_VERTICAL);
+    scrollBar_->SetFixedWidth(12);
+    scrollBar_->SetStepFactor(1.0f);
+
+    for ( unsigned i = 0; i < numRows; ++i )
+    {
+        CreateRadialButton();
+    }
+
+    UpdateScrollRange();
+    BindRows();
+}
+
+void RadialGroup::AddOption(const String& text)
+{
+    optionList_.Push(text);
+
+    UpdateScrollRange();
+
+    if ( optionList_.Size() - 1 < firstOption_ + childList_.Size() )
+    {
+        BindRows();
+    }
+}
+
+void RadialGroup::SetOptions(const Vector<String>& options)
+{
+    optionList_ = options;
+    firstOption_ = 0;
+    selectedIdx_ = 0;
+
+    UpdateScrollRange();
+    BindRows();
+}
+
+unsigned RadialGroup::GetNumOptions() const
+{
+    return virtual_ ? optionList_.Size() : childList_.Size();
+}
+
+void RadialGroup::ScrollTo(unsigned firstOption)
+{
+    if ( !virtual_ )
+        return;
+
+    unsigned maxFirst = optionList_.Size() > childList_.Size() ? optionList_.Size() - childList_.Size() : 0;
+    firstOption = Min(firstOption, maxFirst);
+
+    if ( firstOption == firstOption_ )
+        return;
+
+    firstOption_ = firstOption;
+
+    if ( scrollBar_ && (unsigned)(scrollBar_->GetValue() + 0.5f) != firstOption_ )
+    {
+        scrollBar_->SetValue((float)firstOption_);
+    }
+
+    BindRows();
+}
+
+void RadialGroup::SetSelection(int idx)
+{
+    if ( idx < 0 || idx >= (int)GetNumOptions() )
+        return;
+
+    // only the old and the new selection change
+    CheckBox *chkbox = GetOptionCheckBox(selectedIdx_);
+
+    if ( chkbox )
+        chkbox->SetCheckedInternal(false);
+
+    selectedIdx_ = idx;
+    chkbox = GetOptionCheckBox(selectedIdx_);
+
+    if ( chkbox )
+        chkbox->SetCheckedInternal(true);
+}
+
+CheckBox* RadialGroup::GetOptionCheckBox(int idx)
+{
+    int row = virtual_ ? idx - (int)firstOption_ : idx;
+
+    if ( row < 0 || row >= (int)childList_.Size() )
+        return NULL;
+
+    return childList_[row].checkbox_;
+}
+
+void RadialGroup::UpdateScrollRange()
+{
+    if ( scrollBar_ )
+    {
+        unsigned numRows = childList_.Size();
+        unsigned range = optionList_.Size() > numRows ? optionList_.Size() - numRows : 0;
+
+        scrollBar_->SetRange((float)range);
+        scrollBar_->SetVisible(range > 0);
+    }
+}
+
+void RadialGroup::BindRows()
+{
+    for ( unsigned i = 0; i < childList_.Size(); ++i )
+    {
+        unsigned option = firstOption_ + i;
+        RadialElement &radElem = childList_[i];
+
+        if ( option < optionList_.Size() )
+        {
+            radElem.bodyElement_->SetVisible(true);
+            radElem.textDesc_->SetText(optionList_[option]);
+            radElem.checkbox_->SetCheckedInternal((int)option == selectedIdx_);
+        }
+        else
+        {
+            radElem.bodyElement_->SetVisible(false);
+        }
+    }
+}
+
 Text* RadialGroup::GetTitleTextElement() 
 {
     return headerText_; 
@@ -158,27 +307,32 @@ void RadialGroup::SetEnabled(bool enabled)
             UnsubscribeFromEvent(childList_[i].textDesc_, E_PRESSED);
         }
     }
+
+    if ( virtual_ )
+    {
+        if ( enabled )
+        {
+            SubscribeToEvent(scrollBar_, E_SCROLLBARCHANGED, URHO3D_HANDLER(RadialGroup, HandleScrollBarChanged));
+            SubscribeToEvent(E_MOUSEWHEEL, URHO3D_HANDLER(RadialGroup, HandleMouseWheel));
+        }
+        else
+        {
+            UnsubscribeFromEvent(scrollBar_, E_SCROLLBARCHANGED);
+            UnsubscribeFromEvent(E_MOUSEWHEEL);
+        }
+    }
 }
 
 void RadialGroup::HandlePressed(StringHash eventType, VariantMap& eventData)
 {
     using namespace Pressed;
     UIElement *element = (UIElement*)eventData[P_ELEMENT].GetVoidPtr();
-    int selectedIdx = -1;
-
-    for ( int i = 0; i < (int)childList_.Size(); ++i )
-    {
-        CheckBox *chkbox = childList_[i].checkbox_;
-
-        if (childList_[i].textDesc_ == element && !chkbox->IsChecked())
-            selectedIdx = i;
-
-        chkbox->SetCheckedInternal(childList_[i].textDesc_ == element);
-    }
+    int idx = element->GetVar(VAR_RADIAL_ROW).GetInt() + (virtual_ ? (int)firstOption_ : 0);
 
-    if (selectedIdx >= 0)
+    if (idx != selectedIdx_)
     {
-        SendGroupToggleEvent(selectedIdx);
+        SetSelection(idx);
+        SendGroupToggleEvent(idx);
     }
 }
 
@@ -187,23 +341,33 @@ void RadialGroup::HandleCheckbox(StringHash eventType, VariantMap& eventData)
     using namespace Toggled;
 
     CheckBox *element = (CheckBox*)eventData[P_ELEMENT].GetVoidPtr();
-    bool checked = eventData[P_STATE].GetBool();
-    int checkedIdx = -1;
+    int idx = element->GetVar(VAR_RADIAL_ROW).GetInt() + (virtual_ ? (int)firstOption_ : 0);
 
-    for ( int i = 0; i < (int)childList_.Size(); ++i )
-    {
-        CheckBox *chkbox = childList_[i].checkbox_;
+    // a click on the selected box unchecks it, keep it checked
+    element->SetCheckedInternal(true);
 
-        if (chkbox == element)
-            checkedIdx = i;
+    SetSelection(idx);
+    SendGroupToggleEvent(idx);
+}
 
-        chkbox->SetCheckedInternal(chkbox == element);
-    }
+void RadialGroup::HandleScrollBarChanged(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ScrollBarChanged;
 
-    if (checkedIdx >= 0)
-    {
-        SendGroupToggleEvent(checkedIdx);
-    }
+    ScrollTo((unsigned)(eventData[P_VALUE].GetFloat() + 0.5f));
+}
+
+void RadialGroup::HandleMouseWheel(StringHash eventType, VariantMap& eventData)
+{
+    using namespace MouseWheel;
+
+    if ( !IsVisibleEffective() || !IsInside(GetSubsystem<UI>()->GetCursorPosition(), true) )
+        return;
+
+    int wheel = eventData[P_WHEEL].GetInt();
+    int first = (int)firstOption_ - wheel;
+
+    ScrollTo((unsigned)Max(first, 0));
 }
 
 void RadialGroup::SendGroupToggleEvent(int idx)
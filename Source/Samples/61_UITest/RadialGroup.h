@@ -26,6 +26,7 @@
 namespace Urho3D
 {
 class Text;
+class ScrollBar;
 }
 using namespace Urho3D;
 //=============================================================================
@@ -73,6 +74,18 @@ public:
     RadialElement* CreateRadialButton();
     RadialElement* GetRadialButtonDesc(unsigned idx);
 
+    // virtual mode: the options are plain strings and only numRows radial buttons
+    // are created, they're rebound to the options in view as the list scrolls
+    void SetVirtual(unsigned numRows);
+    bool IsVirtual() const                  { return virtual_; }
+    void AddOption(const String& text);
+    void SetOptions(const Vector<String>& options);
+    unsigned GetNumOptions() const;
+    void ScrollTo(unsigned firstOption);
+
+    void SetSelection(int idx);
+    int GetSelection() const                { return selectedIdx_; }
+
     UIElement* GetHeaderElement() { return headerElement_; }
     UIElement* GetBodyElement()   { return bodyElement_;   }
     Text* GetTitleTextElement();
@@ -87,7 +100,12 @@ public:
 protected:
     void HandleCheckbox(StringHash eventType, VariantMap& eventData);
     void HandlePressed(StringHash eventType, VariantMap& eventData);
+    void HandleScrollBarChanged(StringHash eventType, VariantMap& eventData);
+    void HandleMouseWheel(StringHash eventType, VariantMap& eventData);
     void SendGroupToggleEvent(int idx);
+    CheckBox* GetOptionCheckBox(int idx);
+    void UpdateScrollRange();
+    void BindRows();
 
 protected:
     WeakPtr<UIElement> headerElement_;
@@ -96,6 +114,14 @@ protected:
 
     Vector<RadialElement> childList_;
     IntVector2         internalSize_; 
+    int                selectedIdx_;
+
+    // virtual mode, row i of childList_ shows option firstOption_ + i
+    bool               virtual_;
+    Vector<String>     optionList_;
+    unsigned           firstOption_;
+    WeakPtr<UIElement> rowsElement_;
+    WeakPtr<ScrollBar> scrollBar_;
 };
 
 
@@ -21,7 +21,12 @@
 //
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Resource/XMLFile.h>
 #include <Urho3D/UI/UI.h>
 #include <Urho3D/UI/UIEvents.h>
 #include <Urho3D/UI/Window.h>
@@ -31,24 +36,189 @@
 #include <Urho3D/UI/Font.h>
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
 #include <Urho3D/Resource/XMLElement.h>
 
 #include "SpriteAnimBox.h"
+#include "PageManager.h"
+#include "SpriteAnimator.h"
 
 #include <Urho3D/DebugNew.h>
+//=============================================================================
+//=============================================================================
+#define ATLAS_PADDING   2
+
+//=============================================================================
+//=============================================================================
+void SpriteAnimAtlas::RegisterObject(Context* context)
+{
+    context->RegisterFactory<SpriteAnimAtlas>();
+}
+
+SpriteAnimAtlas::SpriteAnimAtlas(Context *context)
+    : Resource(context)
+{
+}
+
+SpriteAnimAtlas::~SpriteAnimAtlas()
+{
+}
+
+bool SpriteAnimAtlas::BeginLoad(Deserializer& source)
+{
+    loadXMLFile_ = new XMLFile(context_);
+
+    if ( !loadXMLFile_->Load(source) )
+    {
+        loadXMLFile_.Reset();
+        return false;
+    }
+
+    XMLElement root = loadXMLFile_->GetRoot("TextureAtlas");
+
+    if ( !root )
+    {
+        URHO3D_LOGERROR("Invalid sprite sheet " + GetName());
+        loadXMLFile_.Reset();
+        return false;
+    }
+
+    // the image path is relative to the descriptor
+    loadTextureName_ = GetParentPath(GetName()) + root.GetAttribute("imagePath");
+
+    if ( GetAsyncLoadState() == ASYNC_LOADING )
+    {
+        GetSubsystem<ResourceCache>()->BackgroundLoadResource<Texture2D>(loadTextureName_, true, this);
+    }
+
+    return true;
+}
+
+bool SpriteAnimAtlas::EndLoad()
+{
+    if ( loadXMLFile_ == NULL )
+        return false;
+
+    XMLElement root = loadXMLFile_->GetRoot("TextureAtlas");
+    texture_ = GetSubsystem<ResourceCache>()->GetResource<Texture2D>(loadTextureName_);
+    frameRects_.Clear();
+
+    for ( XMLElement frame = root.GetChild("SubTexture"); frame; frame = frame.GetNext("SubTexture") )
+    {
+        int x = frame.GetInt("x");
+        int y = frame.GetInt("y");
+        frameRects_.Push(IntRect(x, y, x + frame.GetInt("width"), y + frame.GetInt("height")));
+    }
+
+    loadXMLFile_.Reset();
+    loadTextureName_.Clear();
+
+    return (texture_ != NULL && frameRects_.Size() > 0);
+}
+
+bool SpriteAnimAtlas::Build(const Vector<String> &frameFiles)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Vector<SharedPtr<Image> > imageList;
+    IntVector2 cellSize(0, 0);
+
+    for ( unsigned i = 0; i < frameFiles.Size(); ++i )
+    {
+        SharedPtr<Image> image(cache->GetResource<Image>(frameFiles[i]));
+
+        if ( image == NULL || image->IsCompressed() )
+        {
+            URHO3D_LOGERROR("SpriteAnimAtlas can't pack " + frameFiles[i]);
+            return false;
+        }
+
+        cellSize.x_ = Max(cellSize.x_, image->GetWidth());
+        cellSize.y_ = Max(cellSize.y_, image->GetHeight());
+        imageList.Push(image);
+    }
+
+    if ( imageList.Empty() )
+        return false;
+
+    // square grid of uniform cells, frames of one animation share a size
+    unsigned cols = (unsigned)Ceil(Sqrt((float)imageList.Size()));
+    unsigned rows = (imageList.Size() + cols - 1) / cols;
+    IntVector2 cell = cellSize + IntVector2(ATLAS_PADDING, ATLAS_PADDING);
+    int width = (int)NextPowerOfTwo(cols * cell.x_);
+    int height = (int)NextPowerOfTwo(rows * cell.y_);
+
+    SharedPtr<Image> atlasImage(new Image(context_));
+    atlasImage->SetSize(width, height, 4);
+    memset(atlasImage->GetData(), 0, width * height * 4);
+
+    frameRects_.Clear();
+
+    for ( unsigned i = 0; i < imageList.Size(); ++i )
+    {
+        Image *image = imageList[i];
+        int x0 = (i % cols) * cell.x_;
+        int y0 = (i / cols) * cell.y_;
+
+        for ( int y = 0; y < image->GetHeight(); ++y )
+        {
+            for ( int x = 0; x < image->GetWidth(); ++x )
+            {
+                atlasImage->SetPixelInt(x0 + x, y0 + y, image->GetPixelInt(x, y));
+            }
+        }
+
+        frameRects_.Push(IntRect(x0, y0, x0 + image->GetWidth(), y0 + image->GetHeight()));
+    }
+
+    // no mips, they would bleed neighbouring frames into each other
+    texture_ = new Texture2D(context_);
+    texture_->SetNumLevels(1);
+
+    if ( !texture_->SetData(atlasImage, true) )
+    {
+        texture_.Reset();
+        frameRects_.Clear();
+        return false;
+    }
+
+    SetMemoryUse(width * height * 4);
+
+    return true;
+}
+
+IntVector2 SpriteAnimAtlas::GetMaxFrameSize() const
+{
+    IntVector2 size(0, 0);
+
+    for ( unsigned i = 0; i < frameRects_.Size(); ++i )
+    {
+        size.x_ = Max(size.x_, frameRects_[i].Width());
+        size.y_ = Max(size.y_, frameRects_[i].Height());
+    }
+
+    return size;
+}
+
 //=============================================================================
 //=============================================================================
 void SpriteAnimBox::RegisterObject(Context* context)
 {
     context->RegisterFactory<SpriteAnimBox>();
+    SpriteAnimAtlas::RegisterObject(context);
 }
 
 SpriteAnimBox::SpriteAnimBox(Context *context)
     : BorderImage(context)
+    , streamAhead_(0)
+    , streamCols_(0)
+    , streamNextSlot_(0)
+    , streamNextFrame_(0)
+    , streamQueued_(0)
     , spriteIndex_(0)
-    , elapsedTime_(0)
-    , frameMsec_(30)
+    , elapsedTime_(0.0f)
+    , frameTime_(1.0f/30.0f)
     , paused_(true)
+    , animSlot_(M_MAX_UNSIGNED)
 {
     SetLayoutMode(LM_VERTICAL);
 
@@ -71,6 +241,7 @@ SpriteAnimBox::SpriteAnimBox(Context *context)
 
 SpriteAnimBox::~SpriteAnimBox()
 {
+    Schedule(false);
 }
 
 void SpriteAnimBox::Create(IntVector2 &size, bool showHeader, bool showControl)
@@ -128,62 +299,386 @@ void SpriteAnimBox::SetHeaderText(const String& text)
 
 void SpriteAnimBox::AddSprite(const String& spriteFile)
 {
+    // packed into the atlas when the box is enabled
+    frameFileList_.Push(spriteFile);
+    atlas_.Reset();
+}
+
+void SpriteAnimBox::SetSpriteSheet(const String& sheetFile)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    frameFileList_.Clear();
+    atlas_ = cache->GetResource<SpriteAnimAtlas>(sheetFile);
+
+    ApplyAtlas();
+}
+
+void SpriteAnimBox::SetStreaming(unsigned framesAhead)
+{
+    StopStream();
+    streamAhead_ = framesAhead;
+    atlas_.Reset();
+}
+
+unsigned SpriteAnimBox::GetNumFrames() const
+{
+    if ( streamAhead_ > 0 )
+        return frameFileList_.Size();
+
+    return atlas_ ? atlas_->GetNumFrames() : 0;
+}
+
+void SpriteAnimBox::LoadAtlas()
+{
+    if ( streamAhead_ > 0 )
+    {
+        StartStream();
+        return;
+    }
+
+    if ( atlas_ || frameFileList_.Empty() )
+    {
+        ApplyAtlas();
+        return;
+    }
+
     ResourceCache* cache = GetSubsystem<ResourceCache>();
-    Texture2D *tex2d = cache->GetResource<Texture2D>(spriteFile);
-    spriteList_.Push(tex2d);
+    String frames;
+
+    for ( unsigned i = 0; i < frameFileList_.Size(); ++i )
+    {
+        frames += cache->SanitateResourceName(frameFileList_[i]) + ";";
+    }
+
+    // boxes playing the same frames share the atlas
+    String atlasName = "SpriteAnimAtlas/" + StringHash(frames).ToString();
+    atlas_ = cache->GetExistingResource<SpriteAnimAtlas>(atlasName);
 
-    if (spriteList_.Size() == 1)
+    if ( atlas_ == NULL )
     {
-        bodyElement_->SetMaxSize(tex2d->GetWidth(), tex2d->GetHeight());
-		bodyElement_->SetTexture(spriteList_[0]);
+        atlas_ = new SpriteAnimAtlas(context_);
+        atlas_->SetName(atlasName);
+
+        if ( !atlas_->Build(frameFileList_) )
+        {
+            atlas_.Reset();
+            return;
+        }
+
+        cache->AddManualResource(atlas_);
     }
+
+    ApplyAtlas();
+}
+
+void SpriteAnimBox::ApplyAtlas()
+{
+    spriteIndex_ = 0;
+
+    if ( atlas_ == NULL || atlas_->GetNumFrames() == 0 )
+        return;
+
+    IntVector2 frameSize = atlas_->GetMaxFrameSize();
+    bodyElement_->SetMaxSize(frameSize.x_, frameSize.y_);
+    bodyElement_->SetTexture(atlas_->GetTexture());
+    bodyElement_->SetImageRect(atlas_->GetFrameRect(0));
+
+    GetSubsystem<SpriteAnimator>()->UpdateAnimation(this);
+}
+
+void SpriteAnimBox::ShowFrame(unsigned idx)
+{
+    if ( streamAhead_ > 0 )
+    {
+        // frames between the last shown and idx have been played, their slots are free
+        unsigned numFrames = frameFileList_.Size();
+        unsigned steps = (idx + numFrames - spriteIndex_) % numFrames;
+
+        spriteIndex_ = idx;
+        streamQueued_ = streamQueued_ > steps ? streamQueued_ - steps : 0;
+
+        // fell behind the decoder, restart the queue at the current frame
+        if ( streamQueued_ == 0 )
+        {
+            streamNextFrame_ = idx;
+        }
+
+        RequestStreamFrames();
+
+        // a frame that isn't decoded yet keeps the previous one on screen
+        int slot = FindStreamSlot(idx);
+
+        if ( slot == -1 || !streamSlotReady_[slot] )
+            return;
+
+        int x = (slot % streamCols_) * streamCellSize_.x_;
+        int y = (slot / streamCols_) * streamCellSize_.y_;
+        bodyElement_->SetImageRect(IntRect(x, y, x + streamCellSize_.x_, y + streamCellSize_.y_));
+    }
+    else
+    {
+        spriteIndex_ = idx;
+        bodyElement_->SetImageRect(atlas_->GetFrameRect(idx));
+    }
+
+    GetSubsystem<PageManager>()->MarkPageDirty(this);
+}
+
+void SpriteAnimBox::StartStream()
+{
+    StopStream();
+
+    if ( frameFileList_.Empty() )
+        return;
+
+    // one slot for the frame on screen plus the frames decoded ahead
+    unsigned numSlots = Min(streamAhead_ + 1, frameFileList_.Size());
+
+    streamSlotFrame_.Resize(numSlots);
+    streamSlotReady_.Resize(numSlots);
+
+    for ( unsigned i = 0; i < numSlots; ++i )
+    {
+        streamSlotFrame_[i] = -1;
+        streamSlotReady_[i] = false;
+    }
+
+    spriteIndex_ = 0;
+    streamNextSlot_ = 0;
+    streamNextFrame_ = 0;
+    streamQueued_ = 0;
+
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(SpriteAnimBox, HandleFrameLoaded));
+
+    RequestStreamFrames();
+    GetSubsystem<SpriteAnimator>()->UpdateAnimation(this);
+}
+
+void SpriteAnimBox::StopStream()
+{
+    UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+
+    streamSlotFrame_.Clear();
+    streamSlotReady_.Clear();
+    streamQueued_ = 0;
+}
+
+void SpriteAnimBox::RequestStreamFrames()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    // the pixels live in the ring, drop decoded images unless someone else holds them
+    for ( unsigned i = 0; i < streamReleaseList_.Size(); ++i )
+    {
+        cache->ReleaseResource(Image::GetTypeStatic(), streamReleaseList_[i]);
+    }
+    streamReleaseList_.Clear();
+
+    while ( streamQueued_ < streamSlotFrame_.Size() )
+    {
+        // the oldest slot holds a frame that has already been shown
+        unsigned slot = streamNextSlot_;
+        unsigned frame = streamNextFrame_;
+
+        streamSlotFrame_[slot] = (int)frame;
+        streamSlotReady_[slot] = false;
+        streamNextSlot_ = (streamNextSlot_ + 1) % streamSlotFrame_.Size();
+        streamNextFrame_ = (streamNextFrame_ + 1) % frameFileList_.Size();
+        ++streamQueued_;
+
+        Image *image = cache->GetExistingResource<Image>(frameFileList_[frame]);
+
+        if ( image == NULL )
+        {
+            // false when it's already queued, then the loaded event still arrives.
+            // without threading the image is loaded right here and no event is sent
+            cache->BackgroundLoadResource<Image>(frameFileList_[frame]);
+            image = cache->GetExistingResource<Image>(frameFileList_[frame]);
+        }
+
+        if ( image )
+        {
+            UploadStreamFrame(slot, image);
+            streamReleaseList_.Push(frameFileList_[frame]);
+        }
+    }
+}
+
+bool SpriteAnimBox::UploadStreamFrame(unsigned slot, Image *image)
+{
+    if ( image->IsCompressed() )
+    {
+        URHO3D_LOGERROR("SpriteAnimBox can't stream " + image->GetName());
+        return false;
+    }
+
+    // the first decoded frame sizes the ring
+    if ( streamTexture_ == NULL || streamCellSize_ != IntVector2(image->GetWidth(), image->GetHeight()) )
+    {
+        unsigned numSlots = streamSlotFrame_.Size();
+
+        streamCellSize_ = IntVector2(image->GetWidth(), image->GetHeight());
+        streamCols_ = (unsigned)Ceil(Sqrt((float)numSlots));
+        unsigned rows = (numSlots + streamCols_ - 1) / streamCols_;
+
+        streamTexture_ = new Texture2D(context_);
+        streamTexture_->SetNumLevels(1);
+        streamTexture_->SetSize(NextPowerOfTwo(streamCols_ * streamCellSize_.x_), NextPowerOfTwo(rows * streamCellSize_.y_), 
+                                Graphics::GetRGBAFormat());
+
+        for ( unsigned i = 0; i < numSlots; ++i )
+        {
+            streamSlotReady_[i] = false;
+        }
+
+        bodyElement_->SetMaxSize(streamCellSize_.x_, streamCellSize_.y_);
+        bodyElement_->SetTexture(streamTexture_);
+    }
+
+    int x = (slot % streamCols_) * streamCellSize_.x_;
+    int y = (slot / streamCols_) * streamCellSize_.y_;
+
+    if ( image->GetComponents() == 4 )
+    {
+        streamTexture_->SetData(0, x, y, streamCellSize_.x_, streamCellSize_.y_, image->GetData());
+    }
+    else
+    {
+        PODVector<unsigned> pixels(streamCellSize_.x_ * streamCellSize_.y_);
+
+        for ( int py = 0; py < streamCellSize_.y_; ++py )
+        {
+            for ( int px = 0; px < streamCellSize_.x_; ++px )
+            {
+                pixels[py * streamCellSize_.x_ + px] = image->GetPixelInt(px, py);
+            }
+        }
+
+        streamTexture_->SetData(0, x, y, streamCellSize_.x_, streamCellSize_.y_, &pixels[0]);
+    }
+
+    streamSlotReady_[slot] = true;
+
+    // playback waits on the frame currently due
+    if ( streamSlotFrame_[slot] == (int)spriteIndex_ )
+    {
+        bodyElement_->SetImageRect(IntRect(x, y, x + streamCellSize_.x_, y + streamCellSize_.y_));
+        GetSubsystem<PageManager>()->MarkPageDirty(this);
+    }
+
+    return true;
+}
+
+int SpriteAnimBox::FindStreamSlot(unsigned frame) const
+{
+    for ( unsigned i = 0; i < streamSlotFrame_.Size(); ++i )
+    {
+        if ( streamSlotFrame_[i] == (int)frame )
+            return (int)i;
+    }
+
+    return -1;
+}
+
+void SpriteAnimBox::HandleFrameLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    if ( !eventData[P_SUCCESS].GetBool() )
+        return;
+
+    const String &name = eventData[P_RESOURCENAME].GetString();
+
+    for ( unsigned i = 0; i < streamSlotFrame_.Size(); ++i )
+    {
+        int frame = streamSlotFrame_[i];
+
+        if ( frame != -1 && !streamSlotReady_[i] && frameFileList_[frame] == name )
+        {
+            UploadStreamFrame(i, static_cast<Image*>(eventData[P_RESOURCE].GetPtr()));
+            break;
+        }
+    }
+
+    // the event still references the image, it's released with the next request
+    if ( frameFileList_.Contains(name) && !streamReleaseList_.Contains(name) )
+    {
+        streamReleaseList_.Push(name);
+    }
+}
+
+void SpriteAnimBox::SetFPS(float fps)
+{
+    assert(fps >= 1.0f);
+    frameTime_ = 1.0f/fps;
+
+    GetSubsystem<SpriteAnimator>()->UpdateAnimation(this);
 }
 
 void SpriteAnimBox::SetEnabled(bool enable)
 {
-    elapsedTime_ = 0;
+    PageManager *pageManager = GetSubsystem<PageManager>();
+
+    // restart from the first frame
+    Schedule(false);
+    elapsedTime_ = 0.0f;
     spriteIndex_ = 0;
 
     if ( enable )
     {
-        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(SpriteAnimBox, HandleUpdate));
+        LoadAtlas();
+
         SubscribeToEvent(playButton_, E_TOGGLED, URHO3D_HANDLER(SpriteAnimBox, HandleCheckbox));
+        pageManager->AddPageActiveCallback(this, (PageActiveCallback)&SpriteAnimBox::HandlePageActive);
     }
     else
     {
-        UnsubscribeFromEvent(E_UPDATE);
         UnsubscribeFromEvent(playButton_, E_TOGGLED);
+        pageManager->RemovePageActiveCallback(this);
     }
+
+    // not animated while our page is hidden
+    Schedule(enable && pageManager->IsPageActive(this));
+}
+
+void SpriteAnimBox::Schedule(bool schedule)
+{
+    SpriteAnimator *animator = GetSubsystem<SpriteAnimator>();
+
+    if ( animator == NULL )
+        return;
+
+    if ( schedule )
+        animator->AddAnimation(this);
+    else
+        animator->RemoveAnimation(this);
 }
 
 void SpriteAnimBox::Play()
 {
     paused_ = false;
+    GetSubsystem<SpriteAnimator>()->UpdateAnimation(this);
 }
 
 void SpriteAnimBox::Pause()
 {
     paused_ = true;
+    GetSubsystem<SpriteAnimator>()->UpdateAnimation(this);
 }
 
 void SpriteAnimBox::Quit()
 {
-    UnsubscribeFromEvent(E_UPDATE);
+    PageManager *pageManager = GetSubsystem<PageManager>();
+
+    Schedule(false);
     UnsubscribeFromEvent(playButton_, E_TOGGLED);
+    pageManager->RemovePageActiveCallback(this);
 }
 
-void SpriteAnimBox::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void SpriteAnimBox::HandlePageActive(bool active)
 {
-    using namespace Update;
-
-    elapsedTime_ += (int)(eventData[P_TIMESTEP].GetFloat() * 1000.0f);
-
-    if ( !paused_ && elapsedTime_ >= frameMsec_ )
-    {
-        elapsedTime_ = 0;
-		spriteIndex_ = ++spriteIndex_ % spriteList_.Size();
-		bodyElement_->SetTexture(spriteList_[spriteIndex_]);
-    }
+    Schedule(active);
 }
 
 void SpriteAnimBox::HandleCheckbox(StringHash eventType, VariantMap& eventData)
@@ -21,20 +21,59 @@
 //
 #pragma once
 #include <Urho3D/UI/Window.h>
+#include <Urho3D/Resource/Resource.h>
 
 namespace Urho3D
 {
 class Text;
 class BorderImage;
 class CheckBox;
+class Texture2D;
+class Image;
+class XMLFile;
 }
 
 using namespace Urho3D;
+//=============================================================================
+// animation frames in one texture, shared through the resource cache
+//=============================================================================
+class SpriteAnimAtlas : public Resource
+{
+    URHO3D_OBJECT(SpriteAnimAtlas, Resource);
+public:
+    static void RegisterObject(Context* context);
+
+    SpriteAnimAtlas(Context *context);
+    virtual ~SpriteAnimAtlas();
+
+    // sprite sheet descriptor:
+    // <TextureAtlas imagePath="sheet.png"> <SubTexture x="" y="" width="" height=""/> ... </TextureAtlas>
+    virtual bool BeginLoad(Deserializer& source);
+    virtual bool EndLoad();
+
+    // packs individual frame images into a new texture
+    bool Build(const Vector<String> &frameFiles);
+
+    Texture2D* GetTexture() const               { return texture_; }
+    unsigned GetNumFrames() const               { return frameRects_.Size(); }
+    const IntRect& GetFrameRect(unsigned idx) const { return frameRects_[idx]; }
+    IntVector2 GetMaxFrameSize() const;
+
+protected:
+    SharedPtr<Texture2D> texture_;
+    PODVector<IntRect>   frameRects_;
+
+    // descriptor loading
+    SharedPtr<XMLFile>   loadXMLFile_;
+    String               loadTextureName_;
+};
+
 //=============================================================================
 //=============================================================================
 class SpriteAnimBox : public BorderImage
 {
     URHO3D_OBJECT(SpriteAnimBox, UIElement);
+    friend class SpriteAnimator;
 public:
     static void RegisterObject(Context* context);
 
@@ -50,12 +89,19 @@ public:
 
     void Create(IntVector2 &size, bool showHeader=false, bool showControl=false);
     void AddSprite(const String& spriteFile);
-    void SetFPS(float fps) { assert(fps >= 1.0f); frameMsec_ = (int)(1000.0f/fps); }
+    void SetSpriteSheet(const String& sheetFile);
+    // long sequences: instead of packing every frame, decode them in the background
+    // this many frames ahead into a fixed ring of slots, 0 packs them into an atlas
+    void SetStreaming(unsigned framesAhead);
+    void SetFPS(float fps);
     void SetEnabled(bool enable);
     void Play();
     void Pause();
     void Quit();
 
+    unsigned GetNumFrames() const;
+    void ShowFrame(unsigned idx);
+
     bool SetHeaderFont(const String& fontName, int size = DEFAULT_FONT_SIZE);
     bool SetHeaderFont(Font* font, int size = DEFAULT_FONT_SIZE);
     bool SetHeaderFontSize(int size);
@@ -63,7 +109,16 @@ public:
 
 protected:
     void SetDefaultPlayButton();
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void LoadAtlas();
+    void ApplyAtlas();
+    void StartStream();
+    void StopStream();
+    void RequestStreamFrames();
+    bool UploadStreamFrame(unsigned slot, Image *image);
+    int FindStreamSlot(unsigned frame) const;
+    void HandleFrameLoaded(StringHash eventType, VariantMap& eventData);
+    void Schedule(bool schedule);
+    void HandlePageActive(bool active);
     void HandleCheckbox(StringHash eventType, VariantMap& eventData);
 
 protected:
@@ -73,10 +128,27 @@ protected:
     WeakPtr<Text>        headerText_;
     WeakPtr<CheckBox>    playButton_;
 
-    Vector<Texture2D*>   spriteList_;
-    int                  spriteIndex_;
-    int                  elapsedTime_;
-    int                  frameMsec_;
+    // frames are image rects in the atlas, flipping them keeps the batch intact
+    SharedPtr<SpriteAnimAtlas> atlas_;
+    Vector<String>       frameFileList_;
+
+    // streaming ring, slot i of streamTexture_ holds frame streamSlotFrame_[i]
+    SharedPtr<Texture2D> streamTexture_;
+    unsigned             streamAhead_;
+    IntVector2           streamCellSize_;
+    unsigned             streamCols_;
+    PODVector<int>       streamSlotFrame_;
+    PODVector<bool>      streamSlotReady_;
+    unsigned             streamNextSlot_;
+    unsigned             streamNextFrame_;
+    unsigned             streamQueued_;
+    Vector<String>       streamReleaseList_;
+    unsigned             spriteIndex_;
+    float                elapsedTime_;
+    float                frameTime_;
     bool                 paused_;
+
+    // slot in the SpriteAnimator while the box is playing on an active page
+    unsigned             animSlot_;
 };
 
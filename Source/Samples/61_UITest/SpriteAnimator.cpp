@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+
+#include "SpriteAnimator.h"
+#include "SpriteAnimBox.h"
+
+#include <Urho3D/DebugNew.h>
+
+//=============================================================================
+//=============================================================================
+void SpriteAnimator::RegisterObject(Context* context)
+{
+    context->RegisterSubsystem( new SpriteAnimator(context) );
+}
+
+SpriteAnimator::SpriteAnimator(Context *context)
+    : Object(context)
+{
+}
+
+SpriteAnimator::~SpriteAnimator()
+{
+}
+
+void SpriteAnimator::AddAnimation(SpriteAnimBox *animBox)
+{
+    if ( animBox->animSlot_ != M_MAX_UNSIGNED )
+        return;
+
+    animBox->animSlot_ = animBoxList_.Size();
+
+    // the time carried over from RemoveAnimation()
+    animBoxList_.Push(animBox);
+    elapsedList_.Push(animBox->elapsedTime_);
+    frameTimeList_.Push(0.0f);
+    frameList_.Push(0);
+    numFramesList_.Push(0);
+    pausedList_.Push(true);
+
+    UpdateAnimation(animBox);
+
+    if ( animBoxList_.Size() == 1 )
+    {
+        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(SpriteAnimator, HandleUpdate));
+    }
+}
+
+void SpriteAnimator::RemoveAnimation(SpriteAnimBox *animBox)
+{
+    unsigned slot = animBox->animSlot_;
+
+    if ( slot == M_MAX_UNSIGNED )
+        return;
+
+    // hand the time state back so playback resumes where it stopped
+    animBox->elapsedTime_ = elapsedList_[slot];
+    animBox->animSlot_ = M_MAX_UNSIGNED;
+
+    // move the last entry into the freed slot
+    unsigned last = animBoxList_.Size() - 1;
+
+    if ( slot != last )
+    {
+        animBoxList_[slot]   = animBoxList_[last];
+        elapsedList_[slot]   = elapsedList_[last];
+        frameTimeList_[slot] = frameTimeList_[last];
+        frameList_[slot]     = frameList_[last];
+        numFramesList_[slot] = numFramesList_[last];
+        pausedList_[slot]    = pausedList_[last];
+
+        animBoxList_[slot]->animSlot_ = slot;
+    }
+
+    animBoxList_.Pop();
+    elapsedList_.Pop();
+    frameTimeList_.Pop();
+    frameList_.Pop();
+    numFramesList_.Pop();
+    pausedList_.Pop();
+
+    if ( animBoxList_.Empty() )
+    {
+        UnsubscribeFromEvent(E_UPDATE);
+    }
+}
+
+void SpriteAnimator::UpdateAnimation(SpriteAnimBox *animBox)
+{
+    unsigned slot = animBox->animSlot_;
+
+    if ( slot == M_MAX_UNSIGNED )
+        return;
+
+    // the elapsed time lives here while scheduled, the box's copy is stale
+    frameTimeList_[slot] = animBox->frameTime_;
+    frameList_[slot]     = animBox->spriteIndex_;
+    numFramesList_[slot] = animBox->GetNumFrames();
+    pausedList_[slot]    = animBox->paused_;
+}
+
+void SpriteAnimator::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    unsigned numAnims = animBoxList_.Size();
+
+    changedList_.Clear();
+
+    for ( unsigned i = 0; i < numAnims; ++i )
+    {
+        if ( pausedList_[i] || numFramesList_[i] < 2 )
+            continue;
+
+        // keep the remainder, a long frame may also skip several sprites
+        float elapsed = elapsedList_[i] + timeStep;
+        float frameTime = frameTimeList_[i];
+
+        if ( elapsed >= frameTime )
+        {
+            unsigned steps = (unsigned)(elapsed / frameTime);
+            elapsed -= steps * frameTime;
+            frameList_[i] = (frameList_[i] + steps) % numFramesList_[i];
+            changedList_.Push(i);
+        }
+
+        elapsedList_[i] = elapsed;
+    }
+
+    for ( unsigned i = 0; i < changedList_.Size(); ++i )
+    {
+        unsigned slot = changedList_[i];
+        animBoxList_[slot]->ShowFrame(frameList_[slot]);
+    }
+}
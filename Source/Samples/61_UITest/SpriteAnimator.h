@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+#include <Urho3D/Core/Object.h>
+
+class SpriteAnimBox;
+
+using namespace Urho3D;
+//=============================================================================
+// advances every playing SpriteAnimBox from one update handler, the state is
+// kept in parallel arrays and only boxes whose frame changed are touched
+//=============================================================================
+class SpriteAnimator : public Object
+{
+    URHO3D_OBJECT(SpriteAnimator, Object);
+public:
+    static void RegisterObject(Context* context);
+
+    SpriteAnimator(Context *context);
+    virtual ~SpriteAnimator();
+
+    void AddAnimation(SpriteAnimBox *animBox);
+    void RemoveAnimation(SpriteAnimBox *animBox);
+    // re-reads frame time, frame count, current frame and paused state from the box
+    void UpdateAnimation(SpriteAnimBox *animBox);
+
+    unsigned GetNumAnimations() const { return animBoxList_.Size(); }
+
+protected:
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+protected:
+    PODVector<SpriteAnimBox*> animBoxList_;
+    PODVector<float>          elapsedList_;
+    PODVector<float>          frameTimeList_;
+    PODVector<unsigned>       frameList_;
+    PODVector<unsigned>       numFramesList_;
+    PODVector<bool>           pausedList_;
+
+    PODVector<unsigned>       changedList_;
+};
@@ -28,11 +28,16 @@
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/UI/CheckBox.h>
 #include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
 
 #include "TabGroup.h"
 
 #include <Urho3D/DebugNew.h>
 
+//=============================================================================
+//=============================================================================
+static const StringHash VAR_TAB_INDEX("TabIndex");
+
 //=============================================================================
 //=============================================================================
 void TabGroup::RegisterObject(Context* context)
@@ -40,7 +45,11 @@ void TabGroup::RegisterObject(Context* context)
     context->RegisterFactory<TabGroup>(UI_CATEGORY);
 }
 
-TabGroup::TabGroup(Context *context) : BorderImage(context)
+TabGroup::TabGroup(Context *context) 
+    : BorderImage(context)
+    , selectedIdx_(0)
+    , builder_(NULL)
+    , pfnBuildCallback_(NULL)
 {
     // default settings
     SetLayoutMode(LM_VERTICAL);
@@ -63,7 +72,6 @@ TabGroup::~TabGroup()
 
 TabElement* TabGroup::CreateTab(const IntVector2 &tabSize, const IntVector2 &bodySize)
 {
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
     TabElement tabElement;
 
     headerElement_->SetMaxHeight(tabSize.y_);
@@ -71,31 +79,88 @@ TabElement* TabGroup::CreateTab(const IntVector2 &tabSize, const IntVector2 &bod
     // button
     tabElement.tabButton_ = headerElement_->CreateChild<CheckBox>();
 
-    tabElement.tabButton_->SetDefaultStyle(cache->GetResource<XMLFile>("UI/DefaultStyle.xml"));
-    tabElement.tabButton_->SetStyle("TabButton");
+    ApplyStyle(tabElement.tabButton_, tabButtonStyle_, "TabButton");
 
     tabElement.tabButton_->SetImageRect(IntRect(208, 64, 224, 80));
     tabElement.tabButton_->SetCheckedOffset(IntVector2(0,16));
 
     tabElement.tabButton_->SetFixedSize(tabSize);
-    tabElement.tabButton_->SetChecked(childList_.Size() == 0);
+    tabElement.tabButton_->SetChecked(childList_.Size() == (unsigned)selectedIdx_);
+    tabElement.tabButton_->SetVar(VAR_TAB_INDEX, childList_.Size());
 
     tabElement.tabText_ = tabElement.tabButton_->CreateChild<Text>();
     tabElement.tabText_->SetAlignment(HA_CENTER, VA_CENTER);
 
-    // body
-    tabElement.tabBody_ = bodyElement_->CreateChild<BorderImage>();
-
-    tabElement.tabBody_->SetStyle("TabBody");
-    tabElement.tabBody_->SetImageRect(IntRect(192, 80, 208, 96));
-    tabElement.tabBody_->SetSize(bodySize);
-    tabElement.tabBody_->SetVisible(childList_.Size() == 0);
+    // the body is created on the first selection
+    tabElement.bodySize_ = bodySize;
 
     childList_.Push(tabElement);
 
     return &childList_.Back();
 }
 
+void TabGroup::ApplyStyle(UIElement *element, TabStyleTemplate &style, const String& styleName)
+{
+    if ( !style.resolved_ )
+    {
+        // the first element takes the style from the xml, its resulting values become the template
+        XMLFile *styleFile = GetDefaultStyle();
+
+        if ( styleFile == NULL )
+        {
+            styleFile = GetSubsystem<ResourceCache>()->GetResource<XMLFile>("UI/DefaultStyle.xml");
+            headerElement_->SetDefaultStyle(styleFile);
+            bodyElement_->SetDefaultStyle(styleFile);
+        }
+
+        style.resolved_ = true;
+
+        if ( styleFile == NULL )
+            return;
+
+        XPathQuery query("/elements/element[@type=$typeName]", "typeName:String");
+        query.SetVariable("typeName", styleName);
+        XMLElement styleElem = styleFile->GetRoot().SelectSinglePrepared(query);
+
+        if ( !styleElem )
+            return;
+
+        // record the values the fully resolved style changes, including what
+        // it inherits through style="..." from its base styles
+        const Vector<AttributeInfo>* attributes = element->GetAttributes();
+        unsigned numAttributes = attributes ? attributes->Size() : 0;
+        Vector<Variant> before(numAttributes);
+
+        for ( unsigned i = 0; i < numAttributes; ++i )
+        {
+            before[i] = element->GetAttribute(i);
+        }
+
+        if ( !element->SetStyle(styleElem) )
+            return;
+
+        for ( unsigned i = 0; i < numAttributes; ++i )
+        {
+            Variant value = element->GetAttribute(i);
+
+            if ( value != before[i] )
+            {
+                style.attributeIndices_.Push(i);
+                style.attributeValues_.Push(value);
+            }
+        }
+
+        return;
+    }
+
+    for ( unsigned i = 0; i < style.attributeIndices_.Size(); ++i )
+    {
+        element->SetAttribute(style.attributeIndices_[i], style.attributeValues_[i]);
+    }
+
+    element->ApplyAttributes();
+}
+
 TabElement* TabGroup::GetTabElement(unsigned idx)
 {
     TabElement *element = NULL;
@@ -106,8 +171,46 @@ TabElement* TabGroup::GetTabElement(unsigned idx)
     return element;
 }
 
+BorderImage* TabGroup::GetTabBody(unsigned idx)
+{
+    if ( idx >= childList_.Size() )
+        return NULL;
+
+    TabElement &tabElement = childList_[idx];
+
+    if ( tabElement.tabBody_ == NULL )
+    {
+        tabElement.tabBody_ = bodyElement_->CreateChild<BorderImage>();
+
+        ApplyStyle(tabElement.tabBody_, tabBodyStyle_, "TabBody");
+
+        tabElement.tabBody_->SetImageRect(IntRect(192, 80, 208, 96));
+        tabElement.tabBody_->SetSize(tabElement.bodySize_);
+        tabElement.tabBody_->SetVisible((int)idx == selectedIdx_);
+
+        if ( builder_ && pfnBuildCallback_ )
+        {
+            (builder_->*pfnBuildCallback_)(this, idx);
+        }
+    }
+
+    return tabElement.tabBody_;
+}
+
+void TabGroup::SetTabBuilder(Object *builder, TabBuildCallback callback)
+{
+    builder_ = builder;
+    pfnBuildCallback_ = callback;
+}
+
 void TabGroup::SetEnabled(bool enabled)
 {
+    // the selected tab is shown right away
+    if ( enabled )
+    {
+        GetTabBody(selectedIdx_);
+    }
+
     for ( int i = 0; i < (int)childList_.Size(); ++i )
     {
         if (enabled)
@@ -127,24 +230,20 @@ void TabGroup::HandleTabToggled(StringHash eventType, VariantMap& eventData)
     using namespace Toggled;
 
     CheckBox *element = (CheckBox*)eventData[P_ELEMENT].GetVoidPtr();
-    bool checked = eventData[P_STATE].GetBool();
-    int checkedIdx = -1;
+    int checkedIdx = element->GetVar(VAR_TAB_INDEX).GetInt();
 
-    for ( int i = 0; i < (int)childList_.Size(); ++i )
-    {
-        CheckBox *chkbox = childList_[i].tabButton_;
+    // only the previous and the new tab change
+    TabElement &prevTab = childList_[selectedIdx_];
+    prevTab.tabButton_->SetCheckedInternal(false);
 
-        if (chkbox == element)
-            checkedIdx = i;
+    if ( prevTab.tabBody_ )
+        prevTab.tabBody_->SetVisible(false);
 
-        chkbox->SetCheckedInternal(chkbox == element);
-        childList_[i].tabBody_->SetVisible(chkbox == element);
-    }
+    selectedIdx_ = checkedIdx;
+    element->SetCheckedInternal(true);
+    GetTabBody(selectedIdx_)->SetVisible(true);
 
-    if (checkedIdx >= 0)
-    {
-        SendTabSelectedEvent(checkedIdx);
-    }
+    SendTabSelectedEvent(checkedIdx);
 }
 
 void TabGroup::SendTabSelectedEvent(int idx)
@@ -41,7 +41,23 @@ struct TabElement
 {
     WeakPtr<CheckBox>    tabButton_;
     WeakPtr<Text>        tabText_;
-    WeakPtr<BorderImage> tabBody_;
+    WeakPtr<BorderImage> tabBody_;     // NULL until the tab is first selected
+    IntVector2           bodySize_;
+};
+
+class TabGroup;
+
+// populates the body of a tab the first time it's selected
+typedef void (Object::*TabBuildCallback)(TabGroup *tabGroup, unsigned idx);
+
+// style attributes resolved once and copied onto each new tab
+struct TabStyleTemplate
+{
+    TabStyleTemplate() : resolved_(false) {}
+
+    PODVector<unsigned> attributeIndices_;
+    Vector<Variant>     attributeValues_;
+    bool                resolved_;
 };
 
 //=============================================================================
@@ -57,6 +73,8 @@ public:
 
     TabElement* CreateTab(const IntVector2 &tabSize, const IntVector2 &bodySize);
     TabElement* GetTabElement(unsigned idx);
+    BorderImage* GetTabBody(unsigned idx);
+    void SetTabBuilder(Object *builder, TabBuildCallback callback);
 
     void SetEnabled(bool enabled);
 
@@ -66,6 +84,7 @@ public:
 protected:
     void HandleTabToggled(StringHash eventType, VariantMap& eventData);
     void SendTabSelectedEvent(int idx);
+    void ApplyStyle(UIElement *element, TabStyleTemplate &style, const String& styleName);
 
 protected:
     WeakPtr<UIElement> headerElement_;
@@ -73,6 +92,13 @@ protected:
 
     IntVector2         internalSize_; 
     Vector<TabElement> childList_;
+    int                selectedIdx_;
+
+    Object*            builder_;
+    TabBuildCallback   pfnBuildCallback_;
+
+    TabStyleTemplate   tabButtonStyle_;
+    TabStyleTemplate   tabBodyStyle_;
 };
 
 